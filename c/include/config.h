@@ -0,0 +1,74 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+#include <limits.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define DEFAULT_PRELOAD_COUNT 2
+#define DEFAULT_PRELOAD_MEMORY_MB 32
+#define DEFAULT_CACHE_MB 512
+#define DEFAULT_REEL_MEMORY_MB 10
+#define DEFAULT_READAHEAD_KB 1024
+#define DEFAULT_FRAME_QUEUE_DEPTH 4
+#define DEFAULT_PLAYLIST_HISTORY 100
+#define DEFAULT_AUDIO_RATE 0 // follow the source
+#define DEFAULT_AUDIO_CHANNELS 0
+#define DEFAULT_AUDIO_BITS 16
+#define DEFAULT_RESUME 1
+#define DEFAULT_SESSION_TTL_MIN 360 // signed reel URLs outlive this, with room to spare
+#define DEFAULT_GOVERNOR 1
+#define DEFAULT_DEBUG_PANEL 0
+#define DEFAULT_SYNC_MASTER SYNC_MASTER_AUDIO
+#define DEFAULT_VIDEO_THREADS 0 // one per core
+// slice: frame threading holds back the first frame by one frame per thread
+#define DEFAULT_VIDEO_THREAD_TYPE CODEC_THREADS_SLICE
+#define DEFAULT_AUDIO_THREADS 1
+#define DEFAULT_AUDIO_THREAD_TYPE CODEC_THREADS_AUTO
+#define MAX_CODEC_THREADS 64
+
+// which clock video frames are scheduled against
+enum sync_master {
+    SYNC_MASTER_AUDIO, // follow the audio device, dropping or repeating frames to stay with it
+    SYNC_MASTER_WALL,  // follow the wall clock, dropping late frames; what reels without audio do
+};
+
+// how a decoder may split its work across threads
+enum codec_thread_type {
+    CODEC_THREADS_AUTO,  // frame or slice, whichever the codec supports (frame preferred)
+    CODEC_THREADS_FRAME, // whole frames in parallel: best throughput, adds a frame of latency per thread
+    CODEC_THREADS_SLICE, // slices of one frame in parallel: no added latency, needs multi-slice streams
+};
+
+// runtime tunables, read once at startup from REELS_* environment variables
+struct app_config {
+    int preload_count;           // REELS_PRELOAD_COUNT: reels opened ahead of the current one
+    size_t preload_memory_bytes; // REELS_PRELOAD_MEMORY_MB: packet memory shared by all preloaded reels
+    char cache_dir[PATH_MAX];    // REELS_CACHE_DIR: defaults to $XDG_CACHE_HOME/reels-cli
+    size_t cache_bytes;          // REELS_CACHE_MB: on-disk media budget, 0 disables the cache
+    size_t reel_memory_bytes;    // REELS_REEL_MEMORY_MB: read-ahead plus demuxed packets of the reel being played
+    size_t readahead_bytes;      // REELS_READAHEAD_KB: network data fetched ahead of the demuxer, at most half of the above
+    size_t packet_memory_bytes;  // what that leaves for demuxed packets
+    size_t frame_queue_depth;    // REELS_FRAME_QUEUE_DEPTH: decoded frames buffered ahead of the renderer
+    int playlist_history;        // REELS_PLAYLIST_HISTORY: watched reels kept for scrolling back
+    int audio_rate;              // REELS_AUDIO_RATE: output sample rate, 0 uses the reel's own
+    int audio_channels;          // REELS_AUDIO_CHANNELS: output channels, 0 uses the reel's own (up to stereo)
+    int audio_bits;              // REELS_AUDIO_BITS: 16 or 32 bit signed output samples
+    int resume;                  // REELS_RESUME: restore the last session's playlist and position
+    long session_ttl;            // REELS_SESSION_TTL_MIN: seconds an uncached restored URL is trusted for
+    int governor;                // REELS_GOVERNOR: lower render quality when frames overrun their interval
+    int debug_panel;             // REELS_DEBUG_PANEL: start with the telemetry lines shown in the info panel
+    enum sync_master sync_master; // REELS_SYNC_MASTER: audio or wall
+    int video_threads;           // REELS_VIDEO_THREADS: video decoder threads, 0 is one per core
+    enum codec_thread_type video_thread_type; // REELS_VIDEO_THREAD_TYPE: auto, frame or slice
+    int audio_threads;           // REELS_AUDIO_THREADS: audio decoder threads, 0 is one per core
+    enum codec_thread_type audio_thread_type; // REELS_AUDIO_THREAD_TYPE: auto, frame or slice
+    char stats_file[PATH_MAX];   // REELS_STATS_FILE: latency histograms are written here on exit, empty to skip
+};
+
+void config_load(struct app_config* config);
+
+#endif // CONFIG_H
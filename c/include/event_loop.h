@@ -0,0 +1,24 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+
+#define EVENT_INPUT  0x1 // notcurses has input waiting
+#define EVENT_NOTIFY 0x2 // another thread called event_loop_notify()
+#define EVENT_TIMER  0x4 // the armed deadline passed
+
+// single epoll wait for everything the main thread reacts to, so it sleeps instead of polling
+struct event_loop {
+    int epoll_fd;
+    int notify_fd; // eventfd, written by the UDS thread when URLs arrive and by a decoder the render loop waits on
+    int timer_fd;  // timerfd for the next frame deadline, finer than epoll's millisecond timeout
+};
+
+int event_loop_init(struct event_loop* loop, int input_fd); // input_fd -1 watches no input
+void event_loop_notify(struct event_loop* loop);
+int event_loop_arm_timer(struct event_loop* loop, double seconds);
+void event_loop_disarm_timer(struct event_loop* loop);
+int event_loop_wait(struct event_loop* loop, int timeout_ms);
+void event_loop_cleanup(struct event_loop* loop);
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,62 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// one decoded picture, converted and ready for the blitter
+struct frame_slot {
+    uint8_t* rgba;
+    size_t capacity; // bytes allocated in rgba, grown by the producer only
+    int width;
+    int height;
+    int stride;
+    double pts;      // presentation time in seconds
+    uint64_t target; // output box it was scaled to fit, 0 if left at the decoded size
+};
+
+// bounded single-producer/single-consumer ring between the decode thread and the render loop.
+// head is only written by the consumer and tail only by the producer, so no lock is needed.
+// the lock and cond are only for parking a producer that found the ring full; a consumer that
+// found it empty sleeps in its own event loop and is woken through notify_fd instead.
+typedef struct {
+    struct frame_slot* slots;
+    size_t depth;
+    size_t head;        // next slot to read, consumer owned
+    size_t tail;        // next slot to write, producer owned
+    int eof;            // producer finished, set after the last push
+    uint64_t underruns; // consumer wanted a frame and the ring was empty
+    uint64_t overruns;  // producer had a frame ready and the ring was full
+    int producer_waiting; // producer owned, so a long stall counts once
+    int consumer_waiting; // consumer owned, same for underruns
+    pthread_mutex_t lock;
+    pthread_cond_t space; // signalled by pop while a producer sleeps
+    int sleeping;         // producer is blocked on space
+    int notify_fd;        // eventfd written when a push lands in a ring the consumer found empty, -1 for none
+    int starved;          // consumer found the ring empty and waits for notify_fd
+} frame_queue;
+
+int frame_queue_init(frame_queue* q, size_t depth);
+void frame_queue_set_notify(frame_queue* q, int fd);
+
+// producer side: slot to fill, or NULL if the ring is full
+struct frame_slot* frame_queue_write_slot(frame_queue* q);
+// same, but sleeps until the consumer frees a slot. NULL once *abort is set
+struct frame_slot* frame_queue_wait_slot(frame_queue* q, const int* abort);
+void frame_queue_wake(frame_queue* q); // after setting abort
+void frame_queue_push(frame_queue* q);
+void frame_queue_set_eof(frame_queue* q);
+
+// consumer side: oldest frame, or NULL if the ring is empty, in which case the next push or
+// eof writes notify_fd
+struct frame_slot* frame_queue_peek(frame_queue* q);
+void frame_queue_pop(frame_queue* q);
+int frame_queue_is_eof(frame_queue* q);
+size_t frame_queue_size(frame_queue* q);
+
+void frame_queue_free(frame_queue* q);
+
+#endif // FRAME_QUEUE_H
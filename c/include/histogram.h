@@ -0,0 +1,25 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define HISTOGRAM_SUB_BITS 2 // 4 buckets per power of two, each at most 25% wide
+#define HISTOGRAM_BUCKETS 252 // enough for any uint64_t value
+
+// log-bucketed histogram of non-negative integer samples (nanoseconds here).
+// one thread records, any thread may merge it at the same time: counters are
+// stored whole with relaxed atomics, so a reader sees a slightly stale but never torn value
+struct histogram {
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+};
+
+void histogram_record(struct histogram* h, uint64_t value);
+void histogram_merge(struct histogram* dst, const struct histogram* src);
+uint64_t histogram_bucket_upper(int bucket);
+uint64_t histogram_percentile(const struct histogram* h, double percentile);
+
+#endif // HISTOGRAM_H
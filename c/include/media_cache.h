@@ -0,0 +1,96 @@
+#ifndef MEDIA_CACHE_H
+#define MEDIA_CACHE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <libavformat/avformat.h>
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define MEDIA_CACHE_DIR_MAX (PATH_MAX - 512) // leaves room for file names under it
+#define MEDIA_CACHE_INDEX_NAME "index"
+#define MEDIA_CACHE_MAX_RANGES 32
+#define MEDIA_IO_BUFFER_SIZE (64 * 1024)
+#define MEDIA_IO_FETCH_SIZE (64 * 1024)  // largest single read the read-ahead thread makes
+#define MEDIA_IO_WAIT_NS 10000000        // 10ms, how often a blocked reader checks for abort
+
+struct cache_entry {
+    uint64_t key;
+    uint64_t size;
+    uint64_t last_access; // logical clock, larger is more recent
+};
+
+// reel media on disk, keyed by a hash of the normalized URL and evicted LRU within a byte budget
+struct media_cache {
+    int enabled;
+    char dir[MEDIA_CACHE_DIR_MAX];
+    uint64_t max_bytes;
+    uint64_t total_bytes;
+    uint64_t clock;
+    struct cache_entry* entries;
+    size_t count;
+    size_t capacity;
+    int dirty; // access order changed since the index was last written
+    unsigned part_counter;
+    pthread_mutex_t mutex;
+};
+
+// byte range of a partially downloaded file that has been written to disk
+struct byte_range {
+    int64_t start;
+    int64_t end;
+};
+
+// custom AVIO backend: serves a reel from the cache, or streams it and fills the cache as it goes
+struct media_io {
+    AVIOContext* avio;    // handed to libavformat as its pb
+    AVIOContext* source;  // network stream, NULL when serving from the cache
+    struct media_cache* cache;
+    uint64_t key;
+    int fd;               // cached file when reading, part file when filling
+    int64_t pos;
+    int64_t size;         // -1 until known
+    int64_t eof_pos;      // where the source reported end of stream, -1 until seen
+    char part_path[PATH_MAX];
+    struct byte_range ranges[MEDIA_CACHE_MAX_RANGES];
+    int range_count;
+    int overflowed;       // too many holes to track, don't commit this download
+
+    // read-ahead, network only: a thread keeps up to ring_size bytes fetched ahead of the demuxer.
+    // the ring holds [ring_start, ring_start + ring_fill), read from the front. a seek outside it is
+    // handed to the thread, which turns it into a range request on the same keep-alive connection
+    AVIOInterruptCB int_cb; // the demuxer's abort check, copied since its format context goes first
+    uint8_t* ring;
+    size_t ring_size;
+    size_t ring_head;     // index of ring_start in ring
+    size_t ring_fill;
+    int64_t ring_start;
+    int64_t fetch_pos;    // source offset the thread reads next, its own
+    int64_t seek_to;      // -1, or where the thread has to move the source before reading on
+    unsigned generation;  // bumped by every seek, data fetched before it is thrown away
+    int fetch_error;      // AVERROR_EOF or the source's error, 0 while data can still come
+    int stop;
+    int thread_running;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint64_t fetched_bytes;  // from the network, for the stats
+    int fetch_seeks;         // seeks that went to the network instead of the ring
+};
+
+int media_cache_init(struct media_cache* cache, const char* dir, uint64_t max_bytes);
+uint64_t media_cache_key(const char* url);
+int media_cache_lookup(struct media_cache* cache, uint64_t key, char* path, size_t path_len);
+int media_cache_part_path(struct media_cache* cache, uint64_t key, char* path, size_t path_len);
+int media_cache_commit(struct media_cache* cache, uint64_t key, const char* part_path, uint64_t size);
+void media_cache_cleanup(struct media_cache* cache);
+
+int media_io_open(struct media_io* io, struct media_cache* cache, const char* url, const AVIOInterruptCB* int_cb,
+                  size_t readahead);
+void media_io_close(struct media_io* io);
+
+#endif // MEDIA_CACHE_H
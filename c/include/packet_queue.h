@@ -0,0 +1,46 @@
+#ifndef PACKET_QUEUE_H
+#define PACKET_QUEUE_H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <libavcodec/avcodec.h>
+
+typedef struct packet_node {
+    AVPacket* pkt;
+    struct packet_node* next;
+} packet_node;
+
+// bounded FIFO of demuxed packets, one per stream, fed by the demux thread
+typedef struct {
+    packet_node* head;
+    packet_node* tail;
+    size_t count;
+    size_t bytes;
+    size_t max_bytes; // put blocks while the queue holds more than this
+    int eof;          // producer is done, drain what is left
+    int aborted;      // consumer is gone, drop everything
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} packet_queue;
+
+int packet_queue_init(packet_queue* q, size_t max_bytes);
+
+// moves the packet's reference into the queue, blocks while full
+int packet_queue_put(packet_queue* q, AVPacket* pkt);
+
+// returns 1 with a packet, 0 if empty and non-blocking, -1 on eof or abort
+int packet_queue_get(packet_queue* q, AVPacket* pkt, int block);
+
+void packet_queue_set_max_bytes(packet_queue* q, size_t max_bytes);
+
+void packet_queue_set_eof(packet_queue* q);
+
+void packet_queue_abort(packet_queue* q);
+
+void packet_queue_flush(packet_queue* q);
+
+void packet_queue_destroy(packet_queue* q);
+
+#endif // PACKET_QUEUE_H
@@ -0,0 +1,43 @@
+#ifndef PCM_RING_H
+#define PCM_RING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// preallocated single-producer/single-consumer byte ring between the audio decoder and the sink thread.
+// head is only written by the consumer and tail only by the producer, so no lock is needed.
+// the lock and cond are only for parking a side that has to wait on the other.
+typedef struct {
+    uint8_t* data;
+    size_t capacity;
+    size_t head;  // bytes read so far, consumer owned
+    size_t tail;  // bytes written so far, producer owned
+    int eof;      // producer finished, set after the last write
+    pthread_mutex_t lock;
+    pthread_cond_t moved; // signalled on write, read and eof while a side sleeps
+    int sleeping;         // sides blocked on moved
+} pcm_ring;
+
+int pcm_ring_init(pcm_ring* ring, size_t capacity);
+
+// producer side: copies up to len bytes in, returns how many fit
+size_t pcm_ring_write(pcm_ring* ring, const uint8_t* data, size_t len);
+void pcm_ring_set_eof(pcm_ring* ring);
+// sleeps until there is room for at least one byte. -1 once *running is cleared
+int pcm_ring_wait_space(pcm_ring* ring, const int* running);
+
+// consumer side: copies up to len bytes out, returns how many were buffered
+size_t pcm_ring_read(pcm_ring* ring, uint8_t* data, size_t len);
+int pcm_ring_is_eof(pcm_ring* ring);
+// sleeps until at least bytes are buffered or the producer finished. -1 once *running is cleared
+int pcm_ring_wait_data(pcm_ring* ring, size_t bytes, const int* running);
+void pcm_ring_wake(pcm_ring* ring); // after clearing running
+
+size_t pcm_ring_size(pcm_ring* ring);
+void pcm_ring_reset(pcm_ring* ring); // only while neither side is running
+void pcm_ring_free(pcm_ring* ring);
+
+#endif // PCM_RING_H
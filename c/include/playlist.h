@@ -0,0 +1,65 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#define PLAYLIST_CHUNK_SIZE (64 * 1024) // arena chunk, a few hundred signed CDN URLs
+#define PLAYLIST_SEGMENT_SIZE 1024      // URL pointers per segment
+#define PLAYLIST_MAX_SEGMENTS 16384     // fixed directory, so segments never move: 16M URLs per session
+
+// block of URL storage; strings are appended and the whole chunk is freed at once
+typedef struct playlist_chunk {
+    struct playlist_chunk* next;
+    size_t used;
+    size_t capacity;
+    size_t last_index; // playlist index of the newest URL stored here
+    char data[];
+} playlist_chunk;
+
+typedef struct {
+    const char* urls[PLAYLIST_SEGMENT_SIZE];
+} playlist_segment;
+
+// URLs in arrival order under stable indices, appended by a single writer (the UDS thread)
+// and read without locks by everyone else. neither segments nor strings move once published,
+// so a reader only has to keep the writer from freeing what it is looking at: it registers in
+// `readers`, and memory behind a trim is freed by the writer only once no reader is registered.
+// a hash of every URL ever added stays behind so duplicates are still rejected in O(1)
+typedef struct {
+    playlist_segment* segments[PLAYLIST_MAX_SEGMENTS];
+    size_t size;           // index the next URL gets, published after the URL is in place
+    size_t first;          // oldest index readers may use, advanced by playlist_trim()
+    int readers;           // readers between playlist_read_begin() and playlist_read_end()
+    // writer owned
+    size_t reclaimed;      // memory before this index has been freed
+    uint64_t* hashes;      // open addressing set of URL hashes, 0 marks an empty slot
+    size_t hash_capacity;
+    size_t hash_count;
+    playlist_chunk* oldest; // arena, oldest chunk first
+    playlist_chunk* newest;
+    size_t arena_bytes;
+} playlist;
+
+int playlist_init(playlist* pl);
+
+// writer side. 1 if added, 0 if the URL was seen before, -1 on allocation failure
+int playlist_push_unique(playlist* pl, const char* url);
+
+// reader side, from any thread
+void playlist_read_begin(playlist* pl);
+const char* playlist_get(playlist* pl, size_t index); // only between begin and end
+void playlist_read_end(playlist* pl);
+char* playlist_dup(playlist* pl, size_t index);       // owned copy, NULL if trimmed or not there yet
+size_t playlist_size(playlist* pl);
+size_t playlist_first(playlist* pl);
+
+// makes entries before `index` unavailable; the writer frees them on a later push
+void playlist_trim(playlist* pl, size_t index);
+
+// with no other thread left using it
+void playlist_free(playlist* pl);
+
+#endif // PLAYLIST_H
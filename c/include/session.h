@@ -0,0 +1,55 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include "playlist.h"
+#include "media_cache.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define SESSION_FILE_NAME "session"
+#define SESSION_MAGIC 0x315345534c454552ULL // "REELSES1" read as little endian
+#define SESSION_VERSION 2
+#define SESSION_MAX_ENTRIES 4096
+#define SESSION_TEXT_BYTES (4 * 1024 * 1024)
+
+// where a URL's text sits in the file, the playlist index it had and when it was recorded
+struct session_entry {
+    uint64_t index;
+    uint32_t offset;
+    uint32_t length; // without the terminating NUL, which is stored too
+    int64_t saved;   // wall clock seconds, signed URLs stop working some hours after this
+};
+
+// the whole file, mapped shared. entries and text are written only by the playlist's writer,
+// current and watched only by the main thread, so nobody needs a lock
+struct session_file {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t entry_count; // stored after the entry and its text are in place
+    uint64_t text_used;
+    uint64_t current;     // playlist index of the reel on screen
+    uint64_t watched;     // every index below this has been started
+    struct session_entry entries[SESSION_MAX_ENTRIES];
+    char text[SESSION_TEXT_BYTES];
+};
+
+// playlist and position kept across runs in a memory-mapped file, so a restart resumes
+// without waiting for the fetcher. the kernel writes dirty pages back on its own
+struct session {
+    struct session_file* map; // NULL when there is no session file
+    int fd;
+    int restored;             // reels put back in the playlist at startup
+};
+
+int session_open(struct session* session, const char* dir);
+int session_restore(struct session* session, playlist* list, struct media_cache* cache, int history, long ttl);
+void session_append(struct session* session, const char* url, size_t index, size_t first);
+void session_set_position(struct session* session, size_t index);
+void session_close(struct session* session);
+
+#endif // SESSION_H
@@ -0,0 +1,30 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include "histogram.h"
+
+// pipeline stages with a latency histogram, all recorded in nanoseconds
+enum stats_metric {
+    STATS_DEMUX,          // av_read_frame, per packet
+    STATS_DECODE,         // video frame out of the codec, demuxer waits included
+    STATS_BLIT,           // ncvisual_blit into the video plane
+    STATS_RENDER,         // notcurses_render: rasterize and write the frame out
+    STATS_AUDIO_DECODE,   // audio frame out of the codec
+    STATS_AO_PLAY,        // ao_play, blocks while the device buffer is full
+    STATS_AV_DRIFT,       // |video clock - audio clock| at each video frame
+    STATS_SCROLL,         // scroll request to the new reel's first frame
+    STATS_ENTER,          // Enter on the home page to the first frame, once per run
+    STATS_FIRST_DECODE,   // video_load to the reel's first decoded frame: open, probe, codec setup, decode
+    STATS_METRIC_COUNT
+};
+
+void stats_init(void);
+void stats_record(enum stats_metric metric, double seconds);
+void stats_snapshot(struct histogram snapshot[STATS_METRIC_COUNT]);
+struct quality_governor;
+
+char* stats_format_json(struct quality_governor* governor, size_t* len);
+void stats_dump(struct quality_governor* governor, const char* path);
+
+#endif // STATS_H
@@ -2,37 +2,85 @@
 #define UDS_SERVER_H
 
 #include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <errno.h>
 #include <fcntl.h>
 
 #define SOCKET_PATH "/tmp/uds_socket"
-#define BUFFER_SIZE 1024
+#define UDS_RECV_CHUNK (64 * 1024)
+#define UDS_HEADER_SIZE 5                  // 4 byte big-endian payload length, then 1 byte type
+#define UDS_MAX_MESSAGE (16 * 1024 * 1024) // anything longer is a broken peer, not a big batch
+#define UDS_MAX_EVENTS 16
+#define UDS_FETCH_TIMEOUT 30.0              // seconds before an unanswered fetch is given up on
+#define UDS_FETCH_RETRY_MS 1000             // how often a waiting fetch looks for a timed out fetcher
+#define UDS_MAX_OUTBOX (4 * 1024 * 1024)   // unsent bytes a client may owe us before it counts as stuck
+
+// every message on the socket is [length][type][payload], in both directions
+enum uds_message_type {
+    UDS_MSG_FETCH = 1, // player -> client: send more reels, empty payload. only to clients that sent HELLO
+    UDS_MSG_URLS = 2,  // client -> player: newline separated batch of reel URLs
+    UDS_MSG_ACK = 3,   // player -> client: one per URLS batch, payload "<added> <received>"
+    UDS_MSG_EXIT = 4,  // player -> client: shut down, empty payload
+    UDS_MSG_STATS = 5, // client -> player: empty request; player -> client: latency histograms as JSON
+    UDS_MSG_HELLO = 6, // client -> player: it fetches reels and wants FETCH requests, empty payload
+};
+
+// receive buffer that grows to fit the largest message seen
+struct uds_buffer {
+    char* data;
+    size_t len;
+    size_t capacity;
+};
 
 // forward declaration
 struct app_state;
 
+// one connected producer, owned by the server thread
+struct uds_client {
+    int fd;
+    struct uds_buffer buffer;  // partial message carried over between reads
+    struct uds_buffer outbox;  // whole frames the socket hasn't taken yet, under server_mutex
+    int output_armed;          // EPOLLOUT is on because the outbox isn't empty
+    int fetcher;               // sent HELLO; clients that only push URLs or ask for stats are never asked for reels
+    int fetch_pending;         // asked for reels and hasn't answered yet
+    double fetch_time;         // when it was last asked
+    int closing;               // a send failed or the outbox overflowed, the server thread closes it on the next wakeup
+    uint64_t urls_received;
+    uint64_t urls_added;       // not already in the playlist
+    uint64_t batches_received;
+    uint64_t fetches_sent;
+};
+
 struct uds_server {
     int server_fd;
-    int client_fd;  // store the connected client file descriptor
+    int epoll_fd;
+    int wake_fd;    // eventfd that gets the server thread out of epoll_wait on stop
     pthread_t server_thread;
     int is_running;
-    int client_connected;  // flag to track if client is connected
+    int client_count;               // connected producers
+    struct uds_client** clients;    // guarded by server_mutex, the main thread sends fetches through it
+    int client_capacity;
     pthread_mutex_t server_mutex;
     struct app_state* app; // reference to app_state for video_list access
+    int fetch_wanted;               // a fetch found no free fetcher, under server_mutex; sent as soon as one is
+    uint64_t urls_received;
+    uint64_t batches_received;
 };
 
 // server functions
 int uds_server_init(struct uds_server* server);
 int uds_server_start(struct uds_server* server);
 void uds_server_stop(struct uds_server* server);
-void uds_server_send(struct uds_server* server, char* message);
+int uds_server_send(struct uds_server* server, enum uds_message_type type, const char* payload, size_t len);
+int uds_server_request_fetch(struct uds_server* server);
 void uds_server_cleanup(struct uds_server* server);
 void* uds_server_thread_func(void* arg);
 
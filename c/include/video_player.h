@@ -14,103 +14,347 @@
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
 #include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
 #include <ao/ao.h>
 #include <unistd.h>
 #include "uds_server.h"
-#include "vector.h"
+#include "event_loop.h"
+#include "playlist.h"
+#include "packet_queue.h"
+#include "frame_queue.h"
+#include "pcm_ring.h"
+#include "config.h"
+#include "media_cache.h"
+#include "session.h"
+#include "stats.h"
 
 #define DEFAULT_FPS 30
 #define FRAME_DELAY_NS 33000000 // 33ms for ~30fps
-#define MAX_AUDIO_DELAY_MS 100
+#define SYNC_THRESHOLD_MIN 0.04     // drift below a frame (but at least this) is left alone, seconds
+#define SYNC_THRESHOLD_MAX 0.1      // and never more than this
+#define SYNC_RESYNC_THRESHOLD 1.0   // beyond this the schedule jumps instead of catching up frame by frame
+#define SYNC_DRIFT_SMOOTHING 0.1    // EMA weight of each new drift sample
+#define DEMUX_PROBE_SIZE (64 * 1024)          // bytes read to find the container, FFmpeg's default is 5 MB
+#define DEMUX_ANALYZE_DURATION (AV_TIME_BASE / 2) // media probed when the header leaves something out
+#define VIDEO_FRAME_PENDING 2
+#define FRAME_LATE_TOLERANCE 0.005 // seconds past due before a frame counts as late
+#define GOVERNOR_MAX_LEVELS 10
+#define INFO_PANEL_WIDTH 30
+#define INFO_FIELDS 2             // dynamic lines of the info panel
+#define INFO_DEBUG_FIELDS 8       // telemetry lines under the controls while the debug panel is on
+#define GOVERNOR_LOG 16           // decisions kept for the stats command
 
 struct av_sync {
     double video_clock;
-    double audio_clock;
-    double frame_timer;
+    double audio_clock; // last audio clock read by the sync engine
+    double frame_timer; // wall-clock time at which start_pts is due
+    double start_pts;   // pts of the first frame, stream time zero for the clocks
+    int has_start_pts;
     double frame_delay;
     double video_pts;
     double audio_pts;
     struct timespec start_time;
+    enum sync_master master; // clock this reel follows, wall when audio was asked for and there is none
+    double drift;            // smoothed video minus audio clock, seconds
+    int repeats;             // frames held longer because video was ahead
+    int resyncs;             // drift too large to catch up, schedule jumped
+};
+
+// audio position published by the sink thread as a seqlock, read with audio_clock_get()
+struct audio_clock {
+    unsigned seq;    // odd while the sink is writing
+    double position; // seconds of audio heard at `updated`
+    double updated;  // wall clock of the last update, 0 until the device first played
+    int running;     // advancing with the wall clock; off while paused or drained
+};
+
+struct playback_metrics {
+    double scroll_time;                // when the last scroll was requested, 0 if none pending
+    double last_scroll_to_first_frame; // seconds from scroll to first rendered frame
+    double total_scroll_to_first_frame;
+    int scrolls;
+    int preload_hits;
+    int preload_misses;
+    double render_time_total; // blit plus notcurses_render, summed over all frames
+    double blit_time_total;   // the ncvisual_blit part of it
+    int rendered_frames;
+    double start_time;          // when main() started
+    double time_to_first_frame; // seconds from start to the first rendered frame, 0 until then
+    double enter_time;          // when Enter left the home page, 0 while it is shown
+    double enter_to_first_frame; // seconds from Enter to the first rendered frame, 0 until then
+};
+
+enum preload_state {
+    PRELOAD_EMPTY,
+    PRELOAD_LOADING,
+    PRELOAD_READY,
+    PRELOAD_FAILED,
+};
+
+struct preload_slot {
+    int video_index;
+    enum preload_state state;
+    struct video_player* player;
+};
+
+// opens and primes the reels after the current one on a background thread
+struct preloader {
+    struct app_state* app;
+    struct preload_slot* slots;
+    int slot_count;
+    int current_index;
+    size_t memory_per_reel;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int is_running;
+    int work_pending;
+    int take_waiting; // preloader_take found its reel still loading, notify the event loop when done
+};
+
+// the one libao device shared by all reels; only the playing reel's sink thread writes to it
+struct audio_output {
+    ao_device* device;
+    ao_sample_format format;    // what the device was opened with
+    ao_sample_format requested; // what the reels asked for, may differ if the device refused it
+    int opens;                  // times the device had to be (re)opened
+    int rate;                   // preferred output from the config, 0 follows the source
+    int channels;
+    int bits;
+};
+
+// one rung of the quality ladder; rung 0 is the best the terminal can do
+struct quality_level {
+    ncblitter_e blitter;
+    int scale;       // video plane size, percent of the layout
+    int fps_divisor; // render every nth frame
+};
+
+struct governor_decision {
+    double time;      // seconds since start
+    int from;
+    int to;
+    double frame_ms;  // blit + render per frame over the window that triggered it
+    double budget_ms;
+};
+
+// steps render quality down when frames cost more than their interval, and back up with headroom
+struct quality_governor {
+    int enabled;
+    struct quality_level levels[GOVERNOR_MAX_LEVELS];
+    int level_count;
+    int level;
+    // current window, main thread only
+    int frames;
+    double cost;
+    uint64_t bytes_start;
+    uint64_t writeout_ns_start;
+    int good_windows;  // in a row with headroom
+    int up_windows;    // needed before stepping up, doubled when a step up fails right away
+    int stable_windows; // since the last change
+    int last_was_up;
+    int skip;          // frames left to skip at a reduced fps
+    // last window, for the info panel and stats. written under mutex
+    double frame_cost;
+    double frame_bytes;
+    double write_rate; // bytes per second of terminal writeout
+    int changes;
+    struct governor_decision log[GOVERNOR_LOG]; // ring, newest at (changes - 1) % GOVERNOR_LOG
+    pthread_mutex_t mutex; // level, last window and log are read by the UDS thread for stats
 };
 
 struct app_state {
     struct notcurses* nc;
     struct ncplane* stdplane;
+    struct ncplane* background_plane; // the gradient, under everything but stdplane, redrawn only on layout changes
+    struct ncplane* video_plane; // persistent output plane every frame is blitted into
+    struct ncplane* ui_plane;    // info panel titles and controls, drawn once
+    struct ncplane* info_plane;  // info panel values, bound to ui_plane
+    char info_fields[INFO_FIELDS][INFO_PANEL_WIDTH]; // what info_plane shows, a line is redrawn only when it changes
+    struct ncplane* debug_plane; // telemetry, bound to ui_plane, only exists while debug_panel is on
+    char debug_fields[INFO_DEBUG_FIELDS][INFO_PANEL_WIDTH];
+    bool debug_panel;            // d toggles it
+    bool layout_changed;         // terminal resized since the video plane was laid out
+    uint64_t video_output_size;  // blitter pixels the video plane holds, (width << 32) | height, 0 until laid out
     ncblitter_e blitter;
     unsigned rows, cols;
     int video_index;
     bool video_scroll; // whether a video scroll was triggered
     bool quit; 
+    bool headless; // --bench: no audio device, output goes to a discard sink
     struct uds_server server; // Unix domain socket server
-    string_vector* video_list;
-    pthread_mutex_t video_list_mutex; // mutex to protect video_list access
+    playlist* video_list; // reel URLs by index, appended by the UDS thread and read lock-free everywhere else
+    struct app_config config;
+    struct media_cache cache;
+    struct session session;   // playlist and position saved for the next start
+    struct preloader preloader;
+    struct playback_metrics metrics;
+    struct audio_output audio_out;
+    struct event_loop events; // input, UDS notifications and frame deadlines for the main thread
+    struct quality_governor governor;
+};
+
+// one demuxer per reel, fanning packets out to the video and audio decoders
+struct demuxer {
+    AVFormatContext* format_ctx;
+    struct media_io io;
+    int uses_media_io; // reading through the cache layer rather than libavformat's own protocol
+    int video_stream_index;
+    int audio_stream_index;
+    packet_queue video_queue;
+    packet_queue audio_queue;
+    pthread_t demux_thread;
+    int is_running;
+    int abort_request;
+    int probed; // avformat_find_stream_info had to read media, the header alone wasn't enough
 };
 
 struct video_player {
     struct ncvisual* ncv;
-    const char* filename;
+    char* filename; // owned copy, the playlist entry may outlive or predate the player
+    struct demuxer demux;
+    AVCodecContext* codec_ctx;
+    struct SwsContext* sws_ctx; // converts and scales to the output size, rebuilt only when either side changes
+    const uint64_t* output_size; // the app's video_output_size, read by the decode thread
+    AVPacket* packet;
+    AVFrame* frame;
+    frame_queue frames; // decoded RGBA frames, decode thread -> render loop
+    pthread_t decode_thread;
+    int decode_running;
+    int decode_abort;
+    int decode_error;
+    double frame_pts; // presentation time of the frame in ncv
+    int frame_prescaled; // ncv already fits the video plane, blit it without scaling
     int frame_count;
     int is_playing;
     struct audio_player* audio;
     struct av_sync sync;
-    double fps;
+    double fps;            // from the stream's avg_frame_rate, DEFAULT_FPS if it has none
     double frame_duration;
+    int is_paused;
+    int frames_displayed;
+    int frames_dropped;    // late enough that a newer frame was already waiting, never blitted
+    int frames_late;       // blitted, but after their due time
+    int frames_decoded;    // decode thread side, read once it has stopped
+    double decode_time;    // seconds spent getting frames out of the codec, demuxer waits included
+    int decode_threads;    // what the codec ended up with, after 0 was resolved
+    double load_start;     // video_load was called
+    double open_time;      // seconds in demuxer_open: connect, header, probing
+    double first_frame_time; // seconds from load_start to the first decoded frame, 0 until then
+    double convert_time;   // seconds in swscale
 };
 
 struct audio_player {
-    AVFormatContext* format_ctx;
+    struct demuxer* demux; // owned by the video player
     AVCodecContext* codec_ctx;
     AVStream* audio_stream;
     SwrContext* swr_ctx;
-    ao_device* ao_device;
-    ao_sample_format ao_format;
+    struct audio_output* output; // the app's device, attached while playing
+    ao_sample_format ao_format;  // what this stream is resampled to
     int audio_stream_index;
     int sample_rate;
     int channels;
+    enum AVSampleFormat sample_fmt; // packed format handed to the device
+    int bytes_per_sample;
     int is_playing;
     int is_paused;
-    pthread_t audio_thread;
+    pthread_t audio_thread; // decodes and resamples into pcm
+    pthread_t sink_thread;  // drains pcm into libao
     pthread_mutex_t audio_mutex;
     pthread_cond_t audio_cond;
-    double audio_clock;
+    pcm_ring pcm;           // resampled samples waiting for the device, preallocated per stream
+    struct audio_clock clock; // seconds of audio heard: bytes handed to libao minus the device latency
     double bytes_per_second;
-    uint64_t total_bytes_played;
-    struct timespec start_time;
+    uint64_t total_bytes_played; // handed to libao, still includes what sits in the device buffer
+    double device_latency;  // estimated seconds between ao_play() and the speaker
+    double anchor_time;     // wall clock when the device last started from empty
+    double anchor_pos;      // seconds of audio handed over at anchor_time
+    uint64_t underruns;     // sink found the ring empty mid-stream
+    double fill_level;      // ring fill at the last device write, 0..1
 };
 
 // app initialization
 int app_init(struct app_state* app);
 void app_cleanup(struct app_state* app);
 
+// headless benchmark of the playback pipeline on local files
+int bench_run(int argc, char** argv);
+
 // home page
 void show_home_page(struct app_state* app);
 
+// demuxer functions
+int demuxer_open(struct demuxer* demux, const char* url, struct media_cache* cache, size_t memory_limit,
+                 size_t readahead);
+int demuxer_start(struct demuxer* demux);
+void demuxer_set_memory_limit(struct demuxer* demux, size_t bytes);
+void demuxer_stop(struct demuxer* demux);
+void demuxer_close(struct demuxer* demux);
+void* demuxer_thread_func(void* arg);
+
 // video player functions
-int video_load(struct video_player* player, const char* filename);
+int video_load(struct app_state* app, struct video_player* player, const char* filename, size_t packet_memory);
+int video_decode_frame(struct video_player* player);
+int video_decoder_start(struct video_player* player);
+void video_decoder_stop(struct video_player* player);
+void* video_decode_thread_func(void* arg);
+int video_next_frame(struct video_player* player, double now, double* wait);
+int video_prime(struct video_player* player);
 int video_play(struct app_state* app, struct video_player* player);
 void video_cleanup(struct video_player* player);
 
+// preloading
+int preloader_init(struct preloader* preloader, struct app_state* app);
+void preloader_update(struct preloader* preloader, int current_index);
+void preloader_notify(struct preloader* preloader);
+struct video_player* preloader_take(struct preloader* preloader, int video_index, int* loading);
+void preloader_cleanup(struct preloader* preloader);
+void* preloader_thread_func(void* arg);
+
 // rendering functions
 ncblitter_e graphics_detect_support(struct notcurses* nc);
+int video_output_plane_update(struct app_state* app);
 struct ncplane* video_render_frame(struct app_state* app, struct video_player* player);
+int video_background_draw(struct app_state* app);
 int video_plane_load(struct app_state* app);
 int render_info_panel(struct app_state* app, struct video_player* player);
+int info_panel_layout(struct app_state* app);
+void info_panel_cleanup(struct app_state* app);
+
+// render quality governor
+void governor_init(struct app_state* app, ncblitter_e best);
+void governor_frame(struct app_state* app, struct video_player* player, double cost);
+int governor_skip_frame(struct app_state* app);
+int governor_scale(struct app_state* app);
+void governor_format_json(struct quality_governor* governor, FILE* out);
+void governor_cleanup(struct quality_governor* governor);
 
 // input handling
 int input_check_quit(struct notcurses* nc);
 int input_handle(struct app_state* app, struct notcurses* nc, struct video_player* player);
 void timing_sleep_frame(void);
 double get_time_in_seconds(void);
-void sync_video_to_audio(struct video_player* player);
+const char* codec_thread_type_name(enum codec_thread_type type);
+void codec_set_threads(AVCodecContext* codec_ctx, int threads, enum codec_thread_type type);
+
+// a/v sync
+void sync_start(struct app_state* app, struct video_player* player);
+void sync_update(struct video_player* player, double now);
+const char* sync_master_name(enum sync_master master);
 
 // audio player functions
 int audio_init(struct audio_player* player);
-int audio_open_url(struct audio_player* player, const char* url);
+int audio_open_stream(struct audio_player* player, struct demuxer* demux, struct audio_output* output,
+                      const struct app_config* config);
+int audio_output_acquire(struct audio_output* output, const ao_sample_format* format);
+void audio_output_close(struct audio_output* output);
 int audio_play(struct audio_player* player);
 void audio_pause(struct audio_player* player);
 void audio_resume(struct audio_player* player);
+int audio_clock_get(struct audio_player* player, double now, double* position);
 void audio_stop(struct audio_player* player);
 void audio_cleanup(struct audio_player* player);
 void* audio_thread_func(void* arg);
+void* audio_sink_thread_func(void* arg);
 
 #endif
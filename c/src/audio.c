@@ -2,16 +2,18 @@
 #include <unistd.h>
 #include <libavutil/opt.h>
 
-#define AUDIO_BUFFER_SIZE 4096
-#define PREBUFFER_FRAMES 10
+#define AUDIO_RING_MS 1000         // decoded audio buffered ahead of the device
+#define AUDIO_PREBUFFER_MS 100     // buffered before the device is (re)started
+#define AUDIO_SINK_CHUNK_MS 10     // written to the device per ao_play()
+#define AUDIO_MAX_LATENCY 0.5      // upper bound for the device latency estimate, seconds
+#define AUDIO_LATENCY_SMOOTHING 0.1
+#define AUDIO_FALLBACK_RATE 44100  // used when the device refuses the requested format
 
 int audio_init(struct audio_player* player) {
     if (!player) return -1;
 
     memset(player, 0, sizeof(struct audio_player));
 
-    ao_initialize();
-
     if (pthread_mutex_init(&player->audio_mutex, NULL) != 0) {
         fprintf(stderr, "Failed to initialize audio mutex\n");
         return -1;
@@ -26,43 +28,70 @@ int audio_init(struct audio_player* player) {
     return 0;
 }
 
-int audio_open_url(struct audio_player* player, const char* url) {
-    if (!player || !url) return -1;
-
-    int ret;
+// sets up the resampler and ring for one output format. runs before playback starts and again
+// if the device could only be opened with a different format than the one asked for
+static int audio_configure_output(struct audio_player* player, const ao_sample_format* format) {
+    player->ao_format = *format;
+    player->sample_rate = format->rate;
+    player->channels = format->channels;
+    player->sample_fmt = format->bits == 32 ? AV_SAMPLE_FMT_S32 : AV_SAMPLE_FMT_S16;
+    player->bytes_per_sample = format->bits / 8;
 
-    player->format_ctx = avformat_alloc_context();
-    if (!player->format_ctx) {
-        fprintf(stderr, "Failed to allocate format context\n");
-        return -1;
+    if (player->swr_ctx) {
+        swr_free(&player->swr_ctx);
     }
 
-    ret = avformat_open_input(&player->format_ctx, url, NULL, NULL);
+    // set up even when the source already has the output format: frames are checked one by
+    // one, so a decoder that changes format mid-stream falls back to it
+    AVChannelLayout out_ch_layout;
+    av_channel_layout_default(&out_ch_layout, player->channels);
+    int ret = swr_alloc_set_opts2(&player->swr_ctx,
+                                  &out_ch_layout, player->sample_fmt, player->sample_rate,
+                                  &player->codec_ctx->ch_layout, player->codec_ctx->sample_fmt,
+                                  player->codec_ctx->sample_rate, 0, NULL);
+    av_channel_layout_uninit(&out_ch_layout);
     if (ret < 0) {
-        fprintf(stderr, "Failed to open URL: %s\n", av_err2str(ret));
+        fprintf(stderr, "Failed to allocate resampler context: %s\n", av_err2str(ret));
         return -1;
     }
 
-    ret = avformat_find_stream_info(player->format_ctx, NULL);
+    ret = swr_init(player->swr_ctx);
     if (ret < 0) {
-        fprintf(stderr, "Failed to find stream info: %s\n", av_err2str(ret));
+        fprintf(stderr, "Failed to initialize resampler: %s\n", av_err2str(ret));
         return -1;
     }
 
-    player->audio_stream_index = -1;
-    for (unsigned int i = 0; i < player->format_ctx->nb_streams; i++) {
-        if (player->format_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-            player->audio_stream_index = i;
-            break;
-        }
+    player->bytes_per_second = (double)player->sample_rate * player->channels * player->bytes_per_sample;
+    player->total_bytes_played = 0;
+    memset(&player->clock, 0, sizeof(player->clock));
+
+    // allocated once here so neither thread allocates while playing
+    pcm_ring_free(&player->pcm);
+    size_t frame_bytes = (size_t)player->bytes_per_sample * player->channels;
+    size_t ring_bytes = (size_t)(player->bytes_per_second * AUDIO_RING_MS / 1000) / frame_bytes * frame_bytes;
+    if (pcm_ring_init(&player->pcm, ring_bytes) < 0) {
+        fprintf(stderr, "Failed to allocate audio ring buffer\n");
+        return -1;
     }
 
-    if (player->audio_stream_index == -1) {
+    return 0;
+}
+
+int audio_open_stream(struct audio_player* player, struct demuxer* demux, struct audio_output* output,
+                      const struct app_config* config) {
+    if (!player || !demux || !demux->format_ctx || !output) return -1;
+
+    int ret;
+
+    if (demux->audio_stream_index < 0) {
         fprintf(stderr, "No audio stream found\n");
         return -1;
     }
 
-    player->audio_stream = player->format_ctx->streams[player->audio_stream_index];
+    player->demux = demux;
+    player->output = output;
+    player->audio_stream_index = demux->audio_stream_index;
+    player->audio_stream = demux->format_ctx->streams[player->audio_stream_index];
 
     const AVCodec* codec = avcodec_find_decoder(player->audio_stream->codecpar->codec_id);
     if (!codec) {
@@ -81,6 +110,7 @@ int audio_open_url(struct audio_player* player, const char* url) {
         fprintf(stderr, "Failed to copy codec parameters: %s\n", av_err2str(ret));
         return -1;
     }
+    codec_set_threads(player->codec_ctx, config->audio_threads, config->audio_thread_type);
 
     ret = avcodec_open2(player->codec_ctx, codec, NULL);
     if (ret < 0) {
@@ -88,162 +118,312 @@ int audio_open_url(struct audio_player* player, const char* url) {
         return -1;
     }
 
-    player->sample_rate = 22050;
-    player->channels = 1; // mono audio
-
-    player->swr_ctx = swr_alloc();
-    if (!player->swr_ctx) {
-        fprintf(stderr, "Failed to allocate resampler context\n");
-        return -1;
+    // output format: the configured one, with 0 meaning "whatever the source has"
+    struct audio_output* out = player->output;
+    ao_sample_format format = {0};
+    format.bits = out->bits;
+    format.rate = out->rate ? out->rate : player->codec_ctx->sample_rate;
+    format.channels = out->channels ? out->channels : player->codec_ctx->ch_layout.nb_channels;
+    if (format.channels > 2 && !out->channels) {
+        format.channels = 2; // downmix surround unless asked for it explicitly
     }
+    format.byte_format = AO_FMT_LITTLE;
 
-    av_opt_set_chlayout(player->swr_ctx, "in_chlayout", &player->codec_ctx->ch_layout, 0);
-    av_opt_set_int(player->swr_ctx, "in_sample_rate", player->codec_ctx->sample_rate, 0);
-    av_opt_set_sample_fmt(player->swr_ctx, "in_sample_fmt", player->codec_ctx->sample_fmt, 0);
-
-    AVChannelLayout out_ch_layout = AV_CHANNEL_LAYOUT_MONO;
-    av_opt_set_chlayout(player->swr_ctx, "out_chlayout", &out_ch_layout, 0);
-    av_opt_set_int(player->swr_ctx, "out_sample_rate", player->sample_rate, 0);
-    av_opt_set_sample_fmt(player->swr_ctx, "out_sample_fmt", AV_SAMPLE_FMT_S16, 0);
-
-    ret = swr_init(player->swr_ctx);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to initialize resampler: %s\n", av_err2str(ret));
-        return -1;
-    }
-
-    int default_driver = ao_default_driver_id();
-
-    int pulse_driver = ao_driver_id("pulse");
-    int driver_to_use = (pulse_driver >= 0) ? pulse_driver : default_driver;
+    return audio_configure_output(player, &format);
+}
 
-    player->ao_format.bits = 16;
-    player->ao_format.channels = player->channels;
-    player->ao_format.rate = player->sample_rate;
-    player->ao_format.byte_format = AO_FMT_LITTLE;
+// packed frames already at the output rate, channel count and sample format go into the ring as
+// they are; everything else, planar float from AAC included, goes through swresample
+static int audio_frame_matches_output(const struct audio_player* player, const AVFrame* frame) {
+    return frame->format == player->sample_fmt &&
+           frame->sample_rate == player->sample_rate &&
+           frame->ch_layout.nb_channels == player->channels;
+}
 
-    player->ao_device = ao_open_live(driver_to_use, &player->ao_format, NULL);
-    if (!player->ao_device) {
-        fprintf(stderr, "Failed to open audio device\n");
-        return -1;
+// copies decoded audio into the ring, sleeping while the sink catches up. -1 if playback stopped
+static int audio_ring_write(struct audio_player* player, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t written = pcm_ring_write(&player->pcm, data, len);
+        data += written;
+        len -= written;
+        if (len == 0) break;
+
+        // a full ring while paused parks here until the sink reads again
+        if (pcm_ring_wait_space(&player->pcm, &player->is_playing) < 0) {
+            return -1;
+        }
     }
-
-    player->bytes_per_second = player->sample_rate * player->channels * 2;
-    player->total_bytes_played = 0;
-    player->audio_clock = 0.0;
-
     return 0;
 }
 
+// decoder side: packets -> samples in the device format in the ring. never touches the device, so a slow
+// packet only eats into the buffered audio instead of stalling output
 void* audio_thread_func(void* arg) {
     struct audio_player* player = (struct audio_player*)arg;
     AVPacket* packet = av_packet_alloc();
     AVFrame* frame = av_frame_alloc();
+    uint8_t* audio_buffer = NULL;
+    int buffer_samples = 0;
 
     if (!packet || !frame) {
         fprintf(stderr, "Failed to allocate packet or frame\n");
         goto cleanup;
     }
 
-    uint8_t* audio_buffer = (uint8_t*)malloc(AUDIO_BUFFER_SIZE * player->channels);
-    if (!audio_buffer) {
-        fprintf(stderr, "Failed to allocate audio buffer\n");
-        goto cleanup;
-    }
-    
-    // Pre-buffer some frames to prevent initial crackling
-    int prebuffer_count = 0;
-    while (player->is_playing && prebuffer_count < PREBUFFER_FRAMES) {
-        pthread_mutex_lock(&player->audio_mutex);
-        int ret = av_read_frame(player->format_ctx, packet);
-        pthread_mutex_unlock(&player->audio_mutex);
-
-        if (ret < 0) break;
-        
-        if (packet->stream_index == player->audio_stream_index) {
-            ret = avcodec_send_packet(player->codec_ctx, packet);
-            if (ret >= 0) {
-                while (avcodec_receive_frame(player->codec_ctx, frame) >= 0) {
-                    int out_samples = swr_convert(player->swr_ctx, 
-                                                (uint8_t**)&audio_buffer, 
-                                                AUDIO_BUFFER_SIZE,
-                                                (const uint8_t**)frame->data, 
-                                                frame->nb_samples);
-
-                    if (out_samples > 0) {
-                        int bytes_to_play = out_samples * 2 * player->channels;
-                        ao_play(player->ao_device, (char*)audio_buffer, bytes_to_play);
-                        prebuffer_count++;
-                    }
+    while (player->is_playing) {
+        // the demuxer only queues audio packets here, no need to filter by stream
+        int ret = packet_queue_get(&player->demux->audio_queue, packet, 1);
+        if (ret < 0) {
+            break;
+        }
+
+        double decode_start = get_time_in_seconds();
+        ret = avcodec_send_packet(player->codec_ctx, packet);
+        av_packet_unref(packet);
+        if (ret < 0) {
+            continue;
+        }
+
+        while (avcodec_receive_frame(player->codec_ctx, frame) >= 0) {
+            stats_record(STATS_AUDIO_DECODE, get_time_in_seconds() - decode_start);
+
+            if (audio_frame_matches_output(player, frame)) {
+                ret = audio_ring_write(player, frame->data[0],
+                                       (size_t)frame->nb_samples * player->bytes_per_sample * player->channels);
+                av_frame_unref(frame);
+                if (ret < 0) {
+                    goto cleanup;
+                }
+                decode_start = get_time_in_seconds();
+                continue;
+            }
+
+            // the resampler may hold samples back, so size for what it could return
+            int max_samples = swr_get_out_samples(player->swr_ctx, frame->nb_samples);
+            if (max_samples > buffer_samples) {
+                uint8_t* buffer = realloc(audio_buffer, (size_t)max_samples * player->bytes_per_sample * player->channels);
+                if (!buffer) {
+                    fprintf(stderr, "Failed to allocate audio buffer\n");
                     av_frame_unref(frame);
+                    goto cleanup;
                 }
+                audio_buffer = buffer;
+                buffer_samples = max_samples;
             }
+
+            int out_samples = swr_convert(player->swr_ctx,
+                                          &audio_buffer,
+                                          buffer_samples,
+                                          (const uint8_t**)frame->extended_data,
+                                          frame->nb_samples);
+
+            if (out_samples > 0) {
+                ret = audio_ring_write(player, audio_buffer, (size_t)out_samples * player->bytes_per_sample * player->channels);
+            }
+            av_frame_unref(frame);
+            if (out_samples > 0 && ret < 0) {
+                goto cleanup;
+            }
+            decode_start = get_time_in_seconds(); // the next frame may come out of the same packet
         }
-        av_packet_unref(packet);
     }
-    
+
+cleanup:
+    pcm_ring_set_eof(&player->pcm);
+    free(audio_buffer);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    return NULL;
+}
+
+// sink thread only. the sequence count is odd while the fields change, so readers retry
+// instead of pairing a new position with an old timestamp
+static void audio_clock_publish(struct audio_clock* clock, double position, double now, int running) {
+    unsigned seq = clock->seq;
+    __atomic_store_n(&clock->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store(&clock->position, &position, __ATOMIC_RELAXED);
+    __atomic_store(&clock->updated, &now, __ATOMIC_RELAXED);
+    __atomic_store_n(&clock->running, running, __ATOMIC_RELAXED);
+    __atomic_store_n(&clock->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// audio position at `now`, extrapolated from the last update while the device is playing.
+// -1 until the device has played anything
+int audio_clock_get(struct audio_player* player, double now, double* position) {
+    struct audio_clock* clock = &player->clock;
+    unsigned seq;
+    double pos, updated;
+    int running;
+    do {
+        seq = __atomic_load_n(&clock->seq, __ATOMIC_ACQUIRE);
+        __atomic_load(&clock->position, &pos, __ATOMIC_RELAXED);
+        __atomic_load(&clock->updated, &updated, __ATOMIC_RELAXED);
+        running = __atomic_load_n(&clock->running, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&clock->seq, __ATOMIC_RELAXED));
+
+    if (updated == 0.0) {
+        return -1;
+    }
+    *position = running ? pos + (now - updated) : pos;
+    return 0;
+}
+
+// sink side: ring -> libao in small chunks. ao_play() blocks once the device buffer is full,
+// so bytes handed over run ahead of what was heard by the device latency; the clock takes it off
+void* audio_sink_thread_func(void* arg) {
+    struct audio_player* player = (struct audio_player*)arg;
+    size_t frame_bytes = (size_t)player->bytes_per_sample * player->channels;
+    size_t chunk_bytes = (size_t)(player->bytes_per_second * AUDIO_SINK_CHUNK_MS / 1000) / frame_bytes * frame_bytes;
+    size_t prebuffer_bytes = (size_t)(player->bytes_per_second * AUDIO_PREBUFFER_MS / 1000);
+
+    uint8_t* chunk = malloc(chunk_bytes);
+    if (!chunk) {
+        fprintf(stderr, "Failed to allocate audio sink buffer\n");
+        return NULL;
+    }
+
+    int starved = 1; // device is empty: wait for a prebuffer, then re-anchor the clock
     while (player->is_playing) {
         if (player->is_paused) {
+            // stop the clock where it is, the video side waits on it
+            double now = get_time_in_seconds();
+            double heard;
+            if (audio_clock_get(player, now, &heard) == 0) {
+                audio_clock_publish(&player->clock, heard, now, 0);
+            }
             pthread_mutex_lock(&player->audio_mutex);
             while (player->is_paused && player->is_playing) {
                 pthread_cond_wait(&player->audio_cond, &player->audio_mutex);
             }
             pthread_mutex_unlock(&player->audio_mutex);
+            starved = 1; // the device drained while paused
+            continue;
+        }
+
+        // restart with some slack so one late packet doesn't starve the device again right away
+        if (starved) {
+            pcm_ring_wait_data(&player->pcm, prebuffer_bytes, &player->is_playing);
             if (!player->is_playing) break;
         }
 
-        pthread_mutex_lock(&player->audio_mutex);
-        int ret = av_read_frame(player->format_ctx, packet);
-        pthread_mutex_unlock(&player->audio_mutex);
+        size_t got = pcm_ring_read(&player->pcm, chunk, chunk_bytes);
+        if (got == 0) {
+            if (pcm_ring_is_eof(&player->pcm)) {
+                break;
+            }
+            if (!starved) {
+                player->underruns++;
+                starved = 1;
+                // the device plays out what it has and goes quiet, so the clock stops at everything handed over
+                audio_clock_publish(&player->clock, (double)player->total_bytes_played / player->bytes_per_second,
+                                    get_time_in_seconds(), 0);
+            }
+            continue; // starved waits for the prebuffer above
+        }
 
-        if (ret < 0) {
-            break;
+        double written = (double)player->total_bytes_played / player->bytes_per_second;
+        if (starved) {
+            // nothing was queued in the device, so everything handed over so far has been heard
+            player->anchor_time = get_time_in_seconds();
+            player->anchor_pos = written;
+            starved = 0;
         }
 
-        if (packet->stream_index != player->audio_stream_index) {
-            av_packet_unref(packet);
-            continue;
+        double play_start = get_time_in_seconds();
+        ao_play(player->output->device, (char*)chunk, got);
+        stats_record(STATS_AO_PLAY, get_time_in_seconds() - play_start);
+        player->total_bytes_played += got;
+        written = (double)player->total_bytes_played / player->bytes_per_second;
+
+        // whatever was handed over beyond the wall time since the anchor is still in the device
+        double now = get_time_in_seconds();
+        double heard = player->anchor_pos + (now - player->anchor_time);
+        double latency = written - heard;
+        if (latency < 0.0) latency = 0.0;
+        if (latency > AUDIO_MAX_LATENCY) latency = AUDIO_MAX_LATENCY;
+        player->device_latency += AUDIO_LATENCY_SMOOTHING * (latency - player->device_latency);
+
+        double clock = written - player->device_latency;
+        audio_clock_publish(&player->clock, clock > 0.0 ? clock : 0.0, now, 1);
+        player->fill_level = (double)pcm_ring_size(&player->pcm) / player->pcm.capacity;
+    }
+
+    free(chunk);
+    return NULL;
+}
+
+static int audio_format_equal(const ao_sample_format* a, const ao_sample_format* b) {
+    return a->bits == b->bits && a->rate == b->rate &&
+           a->channels == b->channels && a->byte_format == b->byte_format;
+}
+
+// opens the shared device on first use and reopens it only if a reel needs a different format.
+// opening a pulse stream per reel cost a noticeable delay on every scroll and could click.
+// a device that refuses the format gets plain 16 bit stereo instead; the caller reads output->format
+int audio_output_acquire(struct audio_output* output, const ao_sample_format* format) {
+    if (output->device) {
+        if (audio_format_equal(&output->format, format) || audio_format_equal(&output->requested, format)) {
+            return 0;
         }
-        
+        ao_close(output->device);
+        output->device = NULL;
+    }
 
-        ret = avcodec_send_packet(player->codec_ctx, packet);
-        av_packet_unref(packet);
-        
-        if (ret >= 0) {
-            while (avcodec_receive_frame(player->codec_ctx, frame) >= 0) {
-                int out_samples = swr_convert(player->swr_ctx, 
-                                            (uint8_t**)&audio_buffer, 
-                                            AUDIO_BUFFER_SIZE,
-                                            (const uint8_t**)frame->data, 
-                                            frame->nb_samples);
-
-                if (out_samples > 0) {
-                    int bytes_to_play = out_samples * 2 * player->channels;
-                    ao_play(player->ao_device, (char*)audio_buffer, bytes_to_play);
-
-                    player->total_bytes_played += bytes_to_play;
-                    player->audio_clock = (double)player->total_bytes_played / player->bytes_per_second;
-                }
+    int default_driver = ao_default_driver_id();
 
-                av_frame_unref(frame);
-            }
+    int pulse_driver = ao_driver_id("pulse");
+    int driver_to_use = (pulse_driver >= 0) ? pulse_driver : default_driver;
+
+    output->requested = *format;
+    output->format = *format;
+    output->device = ao_open_live(driver_to_use, &output->format, NULL);
+    if (!output->device) {
+        ao_sample_format fallback = {0};
+        fallback.bits = 16;
+        fallback.rate = AUDIO_FALLBACK_RATE;
+        fallback.channels = 2;
+        fallback.byte_format = AO_FMT_LITTLE;
+        if (!audio_format_equal(&fallback, format)) {
+            output->format = fallback;
+            output->device = ao_open_live(driver_to_use, &output->format, NULL);
         }
     }
+    if (!output->device) {
+        fprintf(stderr, "Failed to open audio device\n");
+        return -1;
+    }
+    output->opens++;
+    return 0;
+}
 
-cleanup:
-    free(audio_buffer);
-    av_frame_free(&frame);
-    av_packet_free(&packet);
-    return NULL;
+void audio_output_close(struct audio_output* output) {
+    if (output->device) {
+        ao_close(output->device);
+        output->device = NULL;
+    }
 }
 
 int audio_play(struct audio_player* player) {
     if (!player) return -1;
 
+    // only the playing reel attaches, so preloaded reels never touch the device
+    if (audio_output_acquire(player->output, &player->ao_format) < 0) {
+        return -1;
+    }
+    if (!audio_format_equal(&player->output->format, &player->ao_format) &&
+        audio_configure_output(player, &player->output->format) < 0) {
+        return -1;
+    }
+
     player->is_playing = 1;
     player->total_bytes_played = 0;
-    player->audio_clock = 0.0;
-    clock_gettime(CLOCK_MONOTONIC, &player->start_time);
+    memset(&player->clock, 0, sizeof(player->clock)); // threads aren't running yet
+    player->device_latency = 0.0;
+    player->underruns = 0;
+    player->fill_level = 0.0;
+    pcm_ring_reset(&player->pcm);
 
     int ret = pthread_create(&player->audio_thread, NULL, audio_thread_func, player);
     if (ret != 0) {
@@ -251,7 +431,16 @@ int audio_play(struct audio_player* player) {
         player->is_playing = 0;
         return -1;
     }
-    
+
+    ret = pthread_create(&player->sink_thread, NULL, audio_sink_thread_func, player);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to create audio sink thread: %s\n", strerror(ret));
+        player->sink_thread = 0;
+        audio_stop(player);
+        return -1;
+    }
+
+
     return 0;
 }
 
@@ -263,22 +452,29 @@ void audio_stop(struct audio_player* player) {
     player->is_paused = 0;
     pthread_cond_signal(&player->audio_cond);
     pthread_mutex_unlock(&player->audio_mutex);
+    // and both threads if they sleep on the ring
+    pcm_ring_wake(&player->pcm);
+
+    // wake the audio thread if it is waiting on an empty packet queue
+    if (player->demux) {
+        packet_queue_abort(&player->demux->audio_queue);
+    }
 
     if (player->audio_thread) {
         pthread_join(player->audio_thread, NULL);
         player->audio_thread = 0;
     }
+    if (player->sink_thread) {
+        pthread_join(player->sink_thread, NULL);
+        player->sink_thread = 0;
+    }
 }
 
 void audio_cleanup(struct audio_player* player) {
     if (!player) return;
 
+    // the device belongs to the app and stays open for the next reel
     audio_stop(player);
-    
-    if (player->ao_device) {
-        ao_close(player->ao_device);
-        player->ao_device = NULL;
-    }
 
     if (player->swr_ctx) {
         swr_free(&player->swr_ctx);
@@ -288,9 +484,8 @@ void audio_cleanup(struct audio_player* player) {
         avcodec_free_context(&player->codec_ctx);
     }
 
-    if (player->format_ctx) {
-        avformat_close_input(&player->format_ctx);
-    }
+    pcm_ring_free(&player->pcm);
+    player->demux = NULL;
 
     pthread_mutex_destroy(&player->audio_mutex);
     pthread_cond_destroy(&player->audio_cond);
@@ -0,0 +1,339 @@
+#include "include/video_player.h"
+#include <sys/resource.h>
+
+#define BENCH_MAX_PASSES 16
+
+// what one reel cost, stage by stage
+struct bench_result {
+    const char* file;
+    int threads;        // video decoder threads asked for, 0 is one per core
+    int decode_threads; // and what the codec ended up with
+    int ok;
+    double load_time;   // video_load: open, probe, codec setup
+    double open_time;   // the demuxer_open part of it
+    double first_frame_time; // video_load to the first decoded frame
+    int probed;         // the header alone wasn't enough, stream info was probed from media
+    double wall_time;   // first frame requested to last frame rendered
+    double stall_time;  // render loop waiting for the decoder (or the clock, in real time)
+    int frames;
+    int dropped;
+    int late;
+    int decoded;
+    double decode_time;
+    double convert_time;
+    double blit_time;
+    double render_time; // notcurses_render, rasterizing and writing the frame out
+    uint64_t bytes;     // written to the terminal
+};
+
+static void bench_usage(void) {
+    fprintf(stderr, "usage: video_player --bench [--realtime] [--threads n,n,...] <file>...\n");
+}
+
+static void bench_print_string(const char* s) {
+    putchar('"');
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            printf("\\%c", *p);
+        } else if (*p < 0x20) {
+            printf("\\u%04x", *p);
+        } else {
+            putchar(*p);
+        }
+    }
+    putchar('"');
+}
+
+static double bench_per_frame_ms(double seconds, int frames) {
+    return frames > 0 ? seconds * 1000 / frames : 0.0;
+}
+
+// plays one reel through the same decode thread, frame scheduler and renderer as video_play,
+// minus input and audio. as fast as possible, the clock jumps straight to each frame's due time
+static int bench_play(struct app_state* app, struct video_player* player, int realtime, struct bench_result* result) {
+    sync_start(app, player);
+    if (video_decoder_start(player) < 0) {
+        return -1;
+    }
+    if (video_output_plane_update(app) < 0) {
+        video_decoder_stop(player);
+        return -1;
+    }
+
+    double blit_before = app->metrics.blit_time_total;
+    double render_before = app->metrics.render_time_total;
+    double start = get_time_in_seconds();
+    int ret = 0;
+
+    while (1) {
+        double now = get_time_in_seconds();
+        if (!realtime && player->sync.has_start_pts) {
+            struct frame_slot* slot = frame_queue_peek(&player->frames);
+            if (slot) {
+                now = player->sync.frame_timer + (slot->pts - player->sync.start_pts);
+            }
+        }
+
+        double wait = 0.0;
+        int decode_result = video_next_frame(player, now, &wait);
+        if (decode_result == VIDEO_FRAME_PENDING) {
+            double wait_start = get_time_in_seconds();
+            if (wait < 0) {
+                event_loop_wait(&app->events, -1); // the decoder writes the eventfd on its next frame
+            } else {
+                struct timespec ts = { (time_t)wait, (long)((wait - (time_t)wait) * 1e9) };
+                nanosleep(&ts, NULL);
+            }
+            result->stall_time += get_time_in_seconds() - wait_start;
+            continue;
+        } else if (decode_result == 1) {
+            break;
+        } else if (decode_result < 0) {
+            ret = -1;
+            break;
+        }
+
+        player->sync.video_pts = player->frame_pts;
+        player->sync.video_clock = player->frame_pts - player->sync.start_pts;
+        if (player->frame_count > 0 && governor_skip_frame(app)) {
+            player->frames_dropped++;
+            player->frame_count++;
+            continue;
+        }
+        if (video_render_frame(app, player) == NULL) {
+            ret = -1;
+            break;
+        }
+        player->frames_displayed++;
+        player->frame_count++;
+    }
+
+    result->wall_time = get_time_in_seconds() - start;
+    video_decoder_stop(player);
+
+    result->frames = player->frames_displayed;
+    result->dropped = player->frames_dropped;
+    result->late = player->frames_late;
+    result->decoded = player->frames_decoded;
+    result->decode_time = player->decode_time;
+    result->decode_threads = player->decode_threads;
+    result->first_frame_time = player->first_frame_time;
+    result->convert_time = player->convert_time;
+    result->blit_time = app->metrics.blit_time_total - blit_before;
+    result->render_time = (app->metrics.render_time_total - render_before) - result->blit_time;
+    return ret;
+}
+
+// one line per --threads pass: frames out of the codec per second of decoding, over every file
+static void bench_print_threads(struct bench_result* results, int count, int passes) {
+    printf("  \"decode_fps_by_threads\": [");
+    for (int pass = 0; pass < passes; pass++) {
+        struct bench_result* first = &results[pass * count];
+        int decoded = 0;
+        double decode_time = 0.0;
+        for (int i = 0; i < count; i++) {
+            decoded += first[i].decoded;
+            decode_time += first[i].decode_time;
+        }
+        printf("%s{\"threads\": %d, \"decode_threads\": %d, \"decode_fps\": %.1f}", pass ? ", " : "",
+               first->threads, first->decode_threads, decode_time > 0 ? decoded / decode_time : 0.0);
+    }
+    printf("],\n");
+}
+
+static void bench_print(struct app_state* app, struct bench_result* results, int count, int passes, int realtime,
+                        double total_time) {
+    int frames = 0, dropped = 0, failed = 0;
+    uint64_t bytes = 0;
+    int total = count * passes;
+    for (int i = 0; i < total; i++) {
+        frames += results[i].frames;
+        dropped += results[i].dropped;
+        bytes += results[i].bytes;
+        failed += !results[i].ok;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("{\n");
+    printf("  \"mode\": \"%s\",\n", realtime ? "realtime" : "fast");
+    printf("  \"cols\": %u,\n  \"rows\": %u,\n", app->cols, app->rows);
+    printf("  \"blitter\": ");
+    bench_print_string(notcurses_str_blitter(app->blitter));
+    printf(",\n  \"output\": \"%llux%llu\",\n",
+           (unsigned long long)(app->video_output_size >> 32), (unsigned long long)(app->video_output_size & 0xffffffff));
+    printf("  \"video_thread_type\": \"%s\",\n", codec_thread_type_name(app->config.video_thread_type));
+    printf("  \"readahead_kb\": %zu,\n  \"packet_memory_kb\": %zu,\n",
+           app->config.readahead_bytes / 1024, app->config.packet_memory_bytes / 1024);
+    printf("  \"reels\": [\n");
+    for (int i = 0; i < total; i++) {
+        struct bench_result* r = &results[i];
+        printf("    {\"file\": ");
+        bench_print_string(r->file);
+        printf(", \"ok\": %s, \"threads\": %d, \"open_ms\": %.2f, \"probed\": %s, \"load_ms\": %.2f, "
+               "\"first_frame_ms\": %.2f, \"frames\": %d, \"dropped\": %d, \"late\": %d, "
+               "\"fps\": %.1f, \"decode_fps\": %.1f, \"decode_ms\": %.3f, \"convert_ms\": %.3f, \"blit_ms\": %.3f, "
+               "\"render_ms\": %.3f, \"stall_ms\": %.1f, \"bytes\": %llu}%s\n",
+               r->ok ? "true" : "false", r->decode_threads, r->open_time * 1000, r->probed ? "true" : "false",
+               r->load_time * 1000, r->first_frame_time * 1000, r->frames, r->dropped, r->late,
+               r->wall_time > 0 ? r->frames / r->wall_time : 0.0,
+               r->decode_time > 0 ? r->decoded / r->decode_time : 0.0,
+               bench_per_frame_ms(r->decode_time, r->decoded), bench_per_frame_ms(r->convert_time, r->decoded),
+               bench_per_frame_ms(r->blit_time, r->frames), bench_per_frame_ms(r->render_time, r->frames),
+               r->stall_time * 1000, (unsigned long long)r->bytes, i + 1 < total ? "," : "");
+    }
+    printf("  ],\n");
+    bench_print_threads(results, count, passes);
+    printf("  \"frames\": %d,\n  \"dropped\": %d,\n  \"failed\": %d,\n", frames, dropped, failed);
+    printf("  \"seconds\": %.3f,\n  \"fps\": %.1f,\n", total_time, total_time > 0 ? frames / total_time : 0.0);
+    printf("  \"bytes\": %llu,\n  \"bytes_per_frame\": %llu,\n  \"bytes_per_s\": %.0f,\n",
+           (unsigned long long)bytes, (unsigned long long)(frames ? bytes / frames : 0),
+           total_time > 0 ? bytes / total_time : 0.0);
+    printf("  \"quality_changes\": %d,\n", app->governor.changes);
+    printf("  \"peak_rss_kb\": %ld\n", usage.ru_maxrss);
+    printf("}\n");
+}
+
+// "1,2,4,8" into thread counts, one benchmark pass each
+static int bench_parse_threads(const char* list, int* threads) {
+    int passes = 0;
+    const char* p = list;
+    while (*p && passes < BENCH_MAX_PASSES) {
+        char* end;
+        long value = strtol(p, &end, 10);
+        if (end == p || value < 0 || value > MAX_CODEC_THREADS || (*end && *end != ',')) {
+            return -1;
+        }
+        threads[passes++] = (int)value;
+        p = *end ? end + 1 : end;
+    }
+    return *p ? -1 : passes;
+}
+
+// video_player --bench [--realtime] [--threads n,n,...] <files...>: no home page, no UDS client,
+// no audio device. notcurses renders into /dev/null, so the bytes it writes are counted but never
+// drawn. with --threads every file is played once per video decoder thread count
+int bench_run(int argc, char** argv) {
+    int realtime = 0;
+    int first_file = 0;
+    int threads[BENCH_MAX_PASSES];
+    int passes = 0;
+    while (first_file < argc && strncmp(argv[first_file], "--", 2) == 0) {
+        if (strcmp(argv[first_file], "--realtime") == 0) {
+            realtime = 1;
+        } else if (strcmp(argv[first_file], "--threads") == 0 && first_file + 1 < argc) {
+            passes = bench_parse_threads(argv[++first_file], threads);
+            if (passes <= 0) {
+                bench_usage();
+                return EXIT_FAILURE;
+            }
+        } else {
+            bench_usage();
+            return EXIT_FAILURE;
+        }
+        first_file++;
+    }
+    int count = argc - first_file;
+    if (count <= 0) {
+        bench_usage();
+        return EXIT_FAILURE;
+    }
+
+    struct bench_result* results = calloc(count * (passes ? passes : 1), sizeof(struct bench_result));
+    if (!results) {
+        fprintf(stderr, "Failed to allocate benchmark results\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE* sink = fopen("/dev/null", "w");
+    if (!sink) {
+        perror("/dev/null");
+        free(results);
+        return EXIT_FAILURE;
+    }
+
+    setlocale(LC_ALL, "");
+    stats_init();
+    struct app_state app = {0};
+    app.headless = true;
+    config_load(&app.config);
+
+    struct notcurses_options opts = {
+        .flags = NCOPTION_INHIBIT_SETLOCALE | NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN |
+                 NCOPTION_NO_QUIT_SIGHANDLERS | NCOPTION_NO_WINCH_SIGHANDLER | NCOPTION_DRAIN_INPUT,
+    };
+    app.nc = notcurses_init(&opts, sink);
+    if (!app.nc) {
+        fprintf(stderr, "Error initializing notcurses\n");
+        fclose(sink);
+        free(results);
+        return EXIT_FAILURE;
+    }
+    app.stdplane = notcurses_stdplane(app.nc);
+    // no input to watch, only the decoder's wakeups while the render loop waits for a frame
+    if (event_loop_init(&app.events, -1) < 0) {
+        notcurses_stop(app.nc);
+        fclose(sink);
+        free(results);
+        return EXIT_FAILURE;
+    }
+    notcurses_term_dim_yx(app.nc, &app.rows, &app.cols);
+    // fast mode measures one fixed quality; in real time the governor adapts as it would for a viewer
+    app.config.governor = app.config.governor && realtime;
+    governor_init(&app, graphics_detect_support(app.nc));
+    if (passes == 0) {
+        threads[passes++] = app.config.video_threads;
+    }
+
+    double bench_start = get_time_in_seconds();
+    for (int i = 0; i < count * passes; i++) {
+        struct bench_result* result = &results[i];
+        result->file = argv[first_file + i % count];
+        result->threads = threads[i / count];
+        app.config.video_threads = result->threads;
+
+        ncstats before, after;
+        notcurses_stats(app.nc, &before);
+
+        struct video_player player;
+        memset(&player, 0, sizeof(player));
+        double load_start = get_time_in_seconds();
+        if (video_load(&app, &player, result->file, app.config.packet_memory_bytes) < 0) {
+            continue; // reported with ok: false
+        }
+        result->load_time = get_time_in_seconds() - load_start;
+        result->open_time = player.open_time;
+        result->probed = player.demux.probed;
+
+        result->ok = bench_play(&app, &player, realtime, result) == 0;
+        video_cleanup(&player);
+
+        notcurses_stats(app.nc, &after);
+        result->bytes = after.raster_bytes - before.raster_bytes;
+    }
+    double total_time = get_time_in_seconds() - bench_start;
+
+    if (app.video_plane) {
+        ncplane_destroy(app.video_plane);
+    }
+    info_panel_cleanup(&app);
+    if (app.background_plane) {
+        ncplane_destroy(app.background_plane);
+    }
+    notcurses_stop(app.nc);
+    event_loop_cleanup(&app.events);
+    fclose(sink);
+
+    // stdout is untouched by notcurses, so the report can be piped straight into a tool
+    bench_print(&app, results, count, passes, realtime, total_time);
+    stats_dump(&app.governor, app.config.stats_file);
+    governor_cleanup(&app.governor);
+
+    int failed = 0;
+    for (int i = 0; i < count * passes; i++) {
+        failed += !results[i].ok;
+    }
+    free(results);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
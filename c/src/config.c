@@ -0,0 +1,93 @@
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// reads an integer environment variable, falling back to the default when unset or out of range
+static long config_env_long(const char* name, long fallback, long min, long max) {
+    const char* value = getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    }
+
+    char* end;
+    long parsed = strtol(value, &end, 10);
+    if (*end != '\0' || parsed < min || parsed > max) {
+        fprintf(stderr, "Ignoring invalid %s=%s\n", name, value);
+        return fallback;
+    }
+    return parsed;
+}
+
+static enum codec_thread_type config_env_thread_type(const char* name, enum codec_thread_type fallback) {
+    const char* value = getenv(name);
+    if (!value || !*value) {
+        return fallback;
+    } else if (strcmp(value, "auto") == 0) {
+        return CODEC_THREADS_AUTO;
+    } else if (strcmp(value, "frame") == 0) {
+        return CODEC_THREADS_FRAME;
+    } else if (strcmp(value, "slice") == 0) {
+        return CODEC_THREADS_SLICE;
+    }
+    fprintf(stderr, "Ignoring invalid %s=%s\n", name, value);
+    return fallback;
+}
+
+void config_load(struct app_config* config) {
+    config->preload_count = (int)config_env_long("REELS_PRELOAD_COUNT", DEFAULT_PRELOAD_COUNT, 0, 16);
+    config->preload_memory_bytes = (size_t)config_env_long("REELS_PRELOAD_MEMORY_MB", DEFAULT_PRELOAD_MEMORY_MB, 1, 4096) * 1024 * 1024;
+    config->frame_queue_depth = (size_t)config_env_long("REELS_FRAME_QUEUE_DEPTH", DEFAULT_FRAME_QUEUE_DEPTH, 1, 64);
+    config->playlist_history = (int)config_env_long("REELS_PLAYLIST_HISTORY", DEFAULT_PLAYLIST_HISTORY, 1, 1000000);
+    config->audio_rate = (int)config_env_long("REELS_AUDIO_RATE", DEFAULT_AUDIO_RATE, 0, 192000);
+    config->audio_channels = (int)config_env_long("REELS_AUDIO_CHANNELS", DEFAULT_AUDIO_CHANNELS, 0, 8);
+    config->audio_bits = (int)config_env_long("REELS_AUDIO_BITS", DEFAULT_AUDIO_BITS, 16, 32);
+    if (config->audio_bits != 16 && config->audio_bits != 32) {
+        fprintf(stderr, "Ignoring invalid REELS_AUDIO_BITS=%d\n", config->audio_bits);
+        config->audio_bits = DEFAULT_AUDIO_BITS;
+    }
+    config->governor = (int)config_env_long("REELS_GOVERNOR", DEFAULT_GOVERNOR, 0, 1);
+    config->debug_panel = (int)config_env_long("REELS_DEBUG_PANEL", DEFAULT_DEBUG_PANEL, 0, 1);
+    config->resume = (int)config_env_long("REELS_RESUME", DEFAULT_RESUME, 0, 1);
+    config->session_ttl = config_env_long("REELS_SESSION_TTL_MIN", DEFAULT_SESSION_TTL_MIN, 0, 7 * 24 * 60) * 60;
+    config->cache_bytes = (size_t)config_env_long("REELS_CACHE_MB", DEFAULT_CACHE_MB, 0, 1024 * 1024) * 1024 * 1024;
+    config->reel_memory_bytes = (size_t)config_env_long("REELS_REEL_MEMORY_MB", DEFAULT_REEL_MEMORY_MB, 2, 4096) * 1024 * 1024;
+    config->readahead_bytes = (size_t)config_env_long("REELS_READAHEAD_KB", DEFAULT_READAHEAD_KB, 0, 1024 * 1024) * 1024;
+    if (config->readahead_bytes > config->reel_memory_bytes / 2) {
+        config->readahead_bytes = config->reel_memory_bytes / 2;
+    }
+    config->packet_memory_bytes = config->reel_memory_bytes - config->readahead_bytes;
+
+    const char* sync_master = getenv("REELS_SYNC_MASTER");
+    config->sync_master = DEFAULT_SYNC_MASTER;
+    if (sync_master && *sync_master) {
+        if (strcmp(sync_master, "audio") == 0) {
+            config->sync_master = SYNC_MASTER_AUDIO;
+        } else if (strcmp(sync_master, "wall") == 0) {
+            config->sync_master = SYNC_MASTER_WALL;
+        } else {
+            fprintf(stderr, "Ignoring invalid REELS_SYNC_MASTER=%s\n", sync_master);
+        }
+    }
+
+    config->video_threads = (int)config_env_long("REELS_VIDEO_THREADS", DEFAULT_VIDEO_THREADS, 0, MAX_CODEC_THREADS);
+    config->video_thread_type = config_env_thread_type("REELS_VIDEO_THREAD_TYPE", DEFAULT_VIDEO_THREAD_TYPE);
+    config->audio_threads = (int)config_env_long("REELS_AUDIO_THREADS", DEFAULT_AUDIO_THREADS, 0, MAX_CODEC_THREADS);
+    config->audio_thread_type = config_env_thread_type("REELS_AUDIO_THREAD_TYPE", DEFAULT_AUDIO_THREAD_TYPE);
+
+    const char* stats_file = getenv("REELS_STATS_FILE");
+    snprintf(config->stats_file, sizeof(config->stats_file), "%s", stats_file ? stats_file : "");
+
+    const char* cache_dir = getenv("REELS_CACHE_DIR");
+    const char* xdg_cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (cache_dir && *cache_dir) {
+        snprintf(config->cache_dir, sizeof(config->cache_dir), "%s", cache_dir);
+    } else if (xdg_cache && *xdg_cache) {
+        snprintf(config->cache_dir, sizeof(config->cache_dir), "%s/reels-cli", xdg_cache);
+    } else if (home && *home) {
+        snprintf(config->cache_dir, sizeof(config->cache_dir), "%s/.cache/reels-cli", home);
+    } else {
+        config->cache_dir[0] = '\0'; // nowhere to put it, run without a cache
+    }
+}
@@ -0,0 +1,230 @@
+#include "include/video_player.h"
+#include <strings.h>
+
+// lets av_read_frame and friends bail out of a blocking network read on stop
+static int demuxer_interrupt_cb(void* arg) {
+    struct demuxer* demux = (struct demuxer*)arg;
+    return demux->abort_request;
+}
+
+// only remote reels go through the cache, local files are already on disk
+static int demuxer_is_remote(const char* url) {
+    return strncmp(url, "http://", 7) == 0 || strncmp(url, "https://", 8) == 0;
+}
+
+// reels are almost always MP4; naming the demuxer skips probing the first bytes to guess it
+static const AVInputFormat* demuxer_format_hint(const char* url) {
+    size_t len = strcspn(url, "?#");
+    static const char* extensions[] = { ".mp4", ".m4v", ".mov" };
+    for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+        size_t ext_len = strlen(extensions[i]);
+        if (len > ext_len && strncasecmp(url + len - ext_len, extensions[i], ext_len) == 0) {
+            return av_find_input_format("mp4");
+        }
+    }
+    return NULL;
+}
+
+// an MP4 moov box carries codec, size, rate and layout for every track. when it is all there,
+// avformat_find_stream_info would only decode frames to learn what we already know
+static int demuxer_header_complete(AVFormatContext* format_ctx) {
+    int video = 0;
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
+        AVStream* stream = format_ctx->streams[i];
+        AVCodecParameters* par = stream->codecpar;
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            if (par->codec_id == AV_CODEC_ID_NONE || par->width <= 0 || par->height <= 0 ||
+                (stream->avg_frame_rate.num <= 0 && stream->r_frame_rate.num <= 0)) {
+                return 0;
+            }
+            video = 1;
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+            if (par->codec_id == AV_CODEC_ID_NONE || par->sample_rate <= 0 || par->ch_layout.nb_channels <= 0) {
+                return 0;
+            }
+        }
+    }
+    return video;
+}
+
+int demuxer_open(struct demuxer* demux, const char* url, struct media_cache* cache, size_t memory_limit,
+                 size_t readahead) {
+    if (!demux || !url) return -1;
+
+    int ret;
+
+    memset(demux, 0, sizeof(struct demuxer));
+    demux->video_stream_index = -1;
+    demux->audio_stream_index = -1;
+
+    // audio gets an eighth of the budget, its packets are tiny next to video
+    if (packet_queue_init(&demux->video_queue, memory_limit - memory_limit / 8) < 0) {
+        fprintf(stderr, "Failed to initialize video packet queue\n");
+        return -1;
+    }
+    if (packet_queue_init(&demux->audio_queue, memory_limit / 8) < 0) {
+        fprintf(stderr, "Failed to initialize audio packet queue\n");
+        packet_queue_destroy(&demux->video_queue);
+        return -1;
+    }
+
+    demux->format_ctx = avformat_alloc_context();
+    if (!demux->format_ctx) {
+        fprintf(stderr, "Failed to allocate format context\n");
+        goto fail;
+    }
+    demux->format_ctx->interrupt_callback.callback = demuxer_interrupt_cb;
+    demux->format_ctx->interrupt_callback.opaque = demux;
+
+    // a reel needs its header and a frame or two, not the megabytes FFmpeg probes by default
+    demux->format_ctx->probesize = DEMUX_PROBE_SIZE;
+    demux->format_ctx->max_analyze_duration = DEMUX_ANALYZE_DURATION;
+
+    // remote reels always go through our own AVIO: read-ahead, range seeks, and the cache when it is on
+    if (cache && demuxer_is_remote(url)) {
+        if (media_io_open(&demux->io, cache, url, &demux->format_ctx->interrupt_callback, readahead) < 0) {
+            goto fail;
+        }
+        demux->uses_media_io = 1;
+        demux->format_ctx->pb = demux->io.avio;
+        demux->format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
+    // a moov at the end of the file costs a seek there and back; keep-alive lets both range
+    // requests reuse the connection instead of paying for a new connect and TLS handshake
+    AVDictionary* options = NULL;
+    if (demuxer_is_remote(url)) {
+        av_dict_set(&options, "multiple_requests", "1", 0);
+    }
+    ret = avformat_open_input(&demux->format_ctx, url, demuxer_format_hint(url), &options);
+    av_dict_free(&options);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to open URL: %s\n", av_err2str(ret));
+        goto fail;
+    }
+
+    if (!demuxer_header_complete(demux->format_ctx)) {
+        ret = avformat_find_stream_info(demux->format_ctx, NULL);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to find stream info: %s\n", av_err2str(ret));
+            goto fail;
+        }
+        demux->probed = 1;
+    }
+
+    demux->video_stream_index = av_find_best_stream(demux->format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    demux->audio_stream_index = av_find_best_stream(demux->format_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+
+    if (demux->video_stream_index < 0) {
+        fprintf(stderr, "No video stream found\n");
+        goto fail;
+    }
+    if (demux->audio_stream_index < 0) {
+        demux->audio_stream_index = -1;
+        packet_queue_abort(&demux->audio_queue); // nothing will ever read it
+    }
+
+    // don't bother demuxing anything we won't decode (subtitles, data tracks, alternates)
+    for (unsigned int i = 0; i < demux->format_ctx->nb_streams; i++) {
+        if ((int)i != demux->video_stream_index && (int)i != demux->audio_stream_index) {
+            demux->format_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    return 0;
+
+fail:
+    demux->abort_request = 1; // a read-ahead thread stuck on the network gives up
+    if (demux->format_ctx) {
+        avformat_close_input(&demux->format_ctx);
+    }
+    if (demux->uses_media_io) {
+        media_io_close(&demux->io);
+        demux->uses_media_io = 0;
+    }
+    packet_queue_destroy(&demux->video_queue);
+    packet_queue_destroy(&demux->audio_queue);
+    return -1;
+}
+
+void demuxer_set_memory_limit(struct demuxer* demux, size_t bytes) {
+    packet_queue_set_max_bytes(&demux->video_queue, bytes - bytes / 8);
+    packet_queue_set_max_bytes(&demux->audio_queue, bytes / 8);
+}
+
+void* demuxer_thread_func(void* arg) {
+    struct demuxer* demux = (struct demuxer*)arg;
+    AVPacket* packet = av_packet_alloc();
+
+    if (!packet) {
+        fprintf(stderr, "Failed to allocate demux packet\n");
+        goto done;
+    }
+
+    while (!demux->abort_request) {
+        double read_start = get_time_in_seconds();
+        int ret = av_read_frame(demux->format_ctx, packet);
+        stats_record(STATS_DEMUX, get_time_in_seconds() - read_start);
+        if (ret < 0) {
+            if (ret != AVERROR_EOF && !demux->abort_request) {
+                fprintf(stderr, "Error reading packet: %s\n", av_err2str(ret));
+            }
+            break;
+        }
+
+        // route each packet to the queue of its decoder; aborted queues just drop it
+        if (packet->stream_index == demux->video_stream_index) {
+            packet_queue_put(&demux->video_queue, packet);
+        } else if (packet->stream_index == demux->audio_stream_index) {
+            packet_queue_put(&demux->audio_queue, packet);
+        }
+        av_packet_unref(packet);
+    }
+
+done:
+    packet_queue_set_eof(&demux->video_queue);
+    packet_queue_set_eof(&demux->audio_queue);
+    av_packet_free(&packet);
+    return NULL;
+}
+
+int demuxer_start(struct demuxer* demux) {
+    if (!demux || !demux->format_ctx) return -1;
+
+    demux->abort_request = 0;
+    int ret = pthread_create(&demux->demux_thread, NULL, demuxer_thread_func, demux);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to create demux thread: %s\n", strerror(ret));
+        return -1;
+    }
+    demux->is_running = 1;
+    return 0;
+}
+
+void demuxer_stop(struct demuxer* demux) {
+    if (!demux || !demux->is_running) return;
+
+    demux->abort_request = 1;
+    // wake the demux thread if it is blocked on a full queue
+    packet_queue_abort(&demux->video_queue);
+    packet_queue_abort(&demux->audio_queue);
+
+    pthread_join(demux->demux_thread, NULL);
+    demux->is_running = 0;
+}
+
+void demuxer_close(struct demuxer* demux) {
+    if (!demux || !demux->format_ctx) return;
+
+    demuxer_stop(demux);
+    demux->abort_request = 1; // also for a reel that was opened but never started
+
+    avformat_close_input(&demux->format_ctx);
+    // custom pb is ours to free, and closing it is what commits a finished download to the cache
+    if (demux->uses_media_io) {
+        media_io_close(&demux->io);
+        demux->uses_media_io = 0;
+    }
+    packet_queue_destroy(&demux->video_queue);
+    packet_queue_destroy(&demux->audio_queue);
+}
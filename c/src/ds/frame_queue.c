@@ -0,0 +1,148 @@
+#include "frame_queue.h"
+#include <unistd.h>
+
+int frame_queue_init(frame_queue* q, size_t depth) {
+    memset(q, 0, sizeof(frame_queue));
+    if (depth == 0) {
+        return -1;
+    }
+
+    // slots are allocated up front, their pixel buffers on first use and then reused
+    q->slots = calloc(depth, sizeof(struct frame_slot));
+    if (!q->slots) {
+        return -1;
+    }
+    if (pthread_mutex_init(&q->lock, NULL) != 0) {
+        free(q->slots);
+        q->slots = NULL;
+        return -1;
+    }
+    if (pthread_cond_init(&q->space, NULL) != 0) {
+        pthread_mutex_destroy(&q->lock);
+        free(q->slots);
+        q->slots = NULL;
+        return -1;
+    }
+    q->depth = depth;
+    q->notify_fd = -1;
+    return 0;
+}
+
+void frame_queue_set_notify(frame_queue* q, int fd) {
+    q->notify_fd = fd;
+}
+
+// producer side, after publishing a frame or eof. the fence orders that store before the
+// flag load, so a consumer about to sleep either sees the frame or gets the write
+static void frame_queue_notify(frame_queue* q) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (q->notify_fd >= 0 && __atomic_load_n(&q->starved, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&q->starved, 0, __ATOMIC_RELAXED)) {
+        uint64_t one = 1;
+        ssize_t written = write(q->notify_fd, &one, sizeof(one));
+        (void)written; // only fails with a wakeup already pending
+    }
+}
+
+struct frame_slot* frame_queue_write_slot(frame_queue* q) {
+    size_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if (q->tail - head >= q->depth) {
+        // count each time the producer gets stuck, not each time it retries
+        if (!q->producer_waiting) {
+            __atomic_fetch_add(&q->overruns, 1, __ATOMIC_RELAXED);
+            q->producer_waiting = 1;
+        }
+        return NULL;
+    }
+    q->producer_waiting = 0;
+    return &q->slots[q->tail % q->depth];
+}
+
+struct frame_slot* frame_queue_wait_slot(frame_queue* q, const int* abort) {
+    struct frame_slot* slot = frame_queue_write_slot(q);
+    if (slot) {
+        return slot;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    // announce the sleep before the last look at head, pop checks it after moving head
+    __atomic_store_n(&q->sleeping, 1, __ATOMIC_SEQ_CST);
+    while (!__atomic_load_n(abort, __ATOMIC_ACQUIRE) && (slot = frame_queue_write_slot(q)) == NULL) {
+        pthread_cond_wait(&q->space, &q->lock);
+    }
+    __atomic_store_n(&q->sleeping, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&q->lock);
+    return slot;
+}
+
+void frame_queue_wake(frame_queue* q) {
+    pthread_mutex_lock(&q->lock);
+    pthread_cond_broadcast(&q->space);
+    pthread_mutex_unlock(&q->lock);
+}
+
+void frame_queue_push(frame_queue* q) {
+    // release publishes the slot contents together with the new tail
+    __atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+    frame_queue_notify(q);
+}
+
+void frame_queue_set_eof(frame_queue* q) {
+    __atomic_store_n(&q->eof, 1, __ATOMIC_RELEASE);
+    frame_queue_notify(q);
+}
+
+struct frame_slot* frame_queue_peek(frame_queue* q) {
+    size_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    if (q->head == tail && q->notify_fd >= 0) {
+        // ask for a wakeup, then look once more: a push in between either shows up here or sees the flag
+        __atomic_store_n(&q->starved, 1, __ATOMIC_SEQ_CST);
+        tail = __atomic_load_n(&q->tail, __ATOMIC_SEQ_CST);
+        if (q->head != tail) {
+            __atomic_store_n(&q->starved, 0, __ATOMIC_RELAXED);
+        }
+    }
+    if (q->head == tail) {
+        // an empty ring after the producer finished is the end of the stream, not a stall
+        if (!__atomic_load_n(&q->eof, __ATOMIC_ACQUIRE) && !q->consumer_waiting) {
+            __atomic_fetch_add(&q->underruns, 1, __ATOMIC_RELAXED);
+            q->consumer_waiting = 1;
+        }
+        return NULL;
+    }
+    q->consumer_waiting = 0;
+    return &q->slots[q->head % q->depth];
+}
+
+void frame_queue_pop(frame_queue* q) {
+    __atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELEASE);
+    // the fence orders the head store before the flag load, so a producer about to sleep sees the slot or gets woken
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&q->sleeping, __ATOMIC_RELAXED)) {
+        frame_queue_wake(q);
+    }
+}
+
+int frame_queue_is_eof(frame_queue* q) {
+    // eof is stored after the final push, so reading it first guarantees we see that tail
+    int eof = __atomic_load_n(&q->eof, __ATOMIC_ACQUIRE);
+    return eof && q->head == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+}
+
+size_t frame_queue_size(frame_queue* q) {
+    size_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    return tail - head;
+}
+
+void frame_queue_free(frame_queue* q) {
+    if (q->slots) {
+        for (size_t i = 0; i < q->depth; i++) {
+            free(q->slots[i].rgba);
+        }
+        free(q->slots);
+        pthread_cond_destroy(&q->space);
+        pthread_mutex_destroy(&q->lock);
+    }
+    memset(q, 0, sizeof(frame_queue));
+}
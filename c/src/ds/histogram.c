@@ -0,0 +1,75 @@
+#include "histogram.h"
+
+// values below 4 get a bucket each, above that the top three bits pick it: the leading one
+// says which power of two, the two below it which quarter of that range
+static int histogram_bucket(uint64_t value) {
+    if (value < (1u << HISTOGRAM_SUB_BITS)) {
+        return (int)value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << HISTOGRAM_SUB_BITS) + (int)((value >> shift) & ((1u << HISTOGRAM_SUB_BITS) - 1));
+}
+
+uint64_t histogram_bucket_upper(int bucket) {
+    if (bucket < (1 << HISTOGRAM_SUB_BITS)) {
+        return (uint64_t)bucket;
+    }
+    int shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+    uint64_t mantissa = (uint64_t)((bucket & ((1 << HISTOGRAM_SUB_BITS) - 1)) | (1 << HISTOGRAM_SUB_BITS));
+    if (shift + HISTOGRAM_SUB_BITS >= 63 && mantissa == (2u << HISTOGRAM_SUB_BITS) - 1) {
+        return UINT64_MAX;
+    }
+    return ((mantissa + 1) << shift) - 1;
+}
+
+static void histogram_add(uint64_t* counter, uint64_t amount) {
+    // single writer, so a plain read is current; the store only has to be whole for readers
+    __atomic_store_n(counter, *counter + amount, __ATOMIC_RELAXED);
+}
+
+void histogram_record(struct histogram* h, uint64_t value) {
+    histogram_add(&h->buckets[histogram_bucket(value)], 1);
+    histogram_add(&h->count, 1);
+    histogram_add(&h->sum, value);
+    if (value > h->max) {
+        __atomic_store_n(&h->max, value, __ATOMIC_RELAXED);
+    }
+}
+
+void histogram_merge(struct histogram* dst, const struct histogram* src) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->buckets[i] += __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED);
+    }
+    dst->count += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+    dst->sum += __atomic_load_n(&src->sum, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&src->max, __ATOMIC_RELAXED);
+    if (max > dst->max) {
+        dst->max = max;
+    }
+}
+
+// upper edge of the bucket holding the given percentile (0..100), capped at the largest sample
+uint64_t histogram_percentile(const struct histogram* h, double percentile) {
+    uint64_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += h->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t upper = histogram_bucket_upper(i);
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
@@ -0,0 +1,132 @@
+#include "packet_queue.h"
+
+int packet_queue_init(packet_queue* q, size_t max_bytes) {
+    memset(q, 0, sizeof(packet_queue));
+    q->max_bytes = max_bytes;
+
+    if (pthread_mutex_init(&q->mutex, NULL) != 0) {
+        return -1;
+    }
+    if (pthread_cond_init(&q->cond, NULL) != 0) {
+        pthread_mutex_destroy(&q->mutex);
+        return -1;
+    }
+    return 0;
+}
+
+int packet_queue_put(packet_queue* q, AVPacket* pkt) {
+    packet_node* node = malloc(sizeof(packet_node));
+    if (!node) {
+        return -1;
+    }
+    node->pkt = av_packet_alloc();
+    if (!node->pkt) {
+        free(node);
+        return -1;
+    }
+    av_packet_move_ref(node->pkt, pkt);
+    node->next = NULL;
+
+    pthread_mutex_lock(&q->mutex);
+    // always accept at least one packet so a single oversized keyframe cannot wedge the queue
+    while (!q->aborted && q->count > 0 && q->bytes >= q->max_bytes) {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+
+    if (q->aborted) {
+        pthread_mutex_unlock(&q->mutex);
+        av_packet_free(&node->pkt);
+        free(node);
+        return -1;
+    }
+
+    if (q->tail) {
+        q->tail->next = node;
+    } else {
+        q->head = node;
+    }
+    q->tail = node;
+    q->count++;
+    q->bytes += node->pkt->size;
+
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+int packet_queue_get(packet_queue* q, AVPacket* pkt, int block) {
+    pthread_mutex_lock(&q->mutex);
+    while (!q->head && !q->eof && !q->aborted && block) {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+
+    if (q->aborted || (!q->head && q->eof)) {
+        pthread_mutex_unlock(&q->mutex);
+        return -1;
+    }
+
+    packet_node* node = q->head;
+    if (!node) {
+        pthread_mutex_unlock(&q->mutex);
+        return 0;
+    }
+
+    q->head = node->next;
+    if (!q->head) {
+        q->tail = NULL;
+    }
+    q->count--;
+    q->bytes -= node->pkt->size;
+
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+
+    av_packet_move_ref(pkt, node->pkt);
+    av_packet_free(&node->pkt);
+    free(node);
+    return 1;
+}
+
+void packet_queue_set_max_bytes(packet_queue* q, size_t max_bytes) {
+    pthread_mutex_lock(&q->mutex);
+    q->max_bytes = max_bytes;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+void packet_queue_set_eof(packet_queue* q) {
+    pthread_mutex_lock(&q->mutex);
+    q->eof = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+void packet_queue_abort(packet_queue* q) {
+    pthread_mutex_lock(&q->mutex);
+    q->aborted = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+void packet_queue_flush(packet_queue* q) {
+    pthread_mutex_lock(&q->mutex);
+    packet_node* node = q->head;
+    while (node) {
+        packet_node* next = node->next;
+        av_packet_free(&node->pkt);
+        free(node);
+        node = next;
+    }
+    q->head = NULL;
+    q->tail = NULL;
+    q->count = 0;
+    q->bytes = 0;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+void packet_queue_destroy(packet_queue* q) {
+    packet_queue_flush(q);
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->cond);
+}
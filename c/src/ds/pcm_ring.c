@@ -0,0 +1,151 @@
+#include "pcm_ring.h"
+
+int pcm_ring_init(pcm_ring* ring, size_t capacity) {
+    memset(ring, 0, sizeof(pcm_ring));
+    if (capacity == 0) {
+        return -1;
+    }
+
+    ring->data = malloc(capacity);
+    if (!ring->data) {
+        return -1;
+    }
+    if (pthread_mutex_init(&ring->lock, NULL) != 0) {
+        free(ring->data);
+        ring->data = NULL;
+        return -1;
+    }
+    if (pthread_cond_init(&ring->moved, NULL) != 0) {
+        pthread_mutex_destroy(&ring->lock);
+        free(ring->data);
+        ring->data = NULL;
+        return -1;
+    }
+    ring->capacity = capacity;
+    return 0;
+}
+
+void pcm_ring_wake(pcm_ring* ring) {
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_broadcast(&ring->moved);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+// called after moving head, tail or eof. the fence orders that store before the flag load,
+// so a side about to sleep either sees the move or gets woken
+static void pcm_ring_notify(pcm_ring* ring) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->sleeping, __ATOMIC_RELAXED)) {
+        pcm_ring_wake(ring);
+    }
+}
+
+static size_t pcm_ring_space(pcm_ring* ring) {
+    return ring->capacity - pcm_ring_size(ring);
+}
+
+int pcm_ring_wait_space(pcm_ring* ring, const int* running) {
+    pthread_mutex_lock(&ring->lock);
+    __atomic_fetch_add(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(running, __ATOMIC_ACQUIRE) && pcm_ring_space(ring) == 0) {
+        pthread_cond_wait(&ring->moved, &ring->lock);
+    }
+    __atomic_fetch_sub(&ring->sleeping, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&ring->lock);
+    return __atomic_load_n(running, __ATOMIC_ACQUIRE) ? 0 : -1;
+}
+
+int pcm_ring_wait_data(pcm_ring* ring, size_t bytes, const int* running) {
+    if (bytes > ring->capacity) {
+        bytes = ring->capacity;
+    }
+    pthread_mutex_lock(&ring->lock);
+    __atomic_fetch_add(&ring->sleeping, 1, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(running, __ATOMIC_ACQUIRE) && pcm_ring_size(ring) < bytes &&
+           !__atomic_load_n(&ring->eof, __ATOMIC_ACQUIRE)) {
+        pthread_cond_wait(&ring->moved, &ring->lock);
+    }
+    __atomic_fetch_sub(&ring->sleeping, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&ring->lock);
+    return __atomic_load_n(running, __ATOMIC_ACQUIRE) ? 0 : -1;
+}
+
+size_t pcm_ring_write(pcm_ring* ring, const uint8_t* data, size_t len) {
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t space = ring->capacity - (ring->tail - head);
+    if (len > space) {
+        len = space;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    // the write may wrap, in which case it lands in two pieces
+    size_t offset = ring->tail % ring->capacity;
+    size_t first = ring->capacity - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->data + offset, data, first);
+    memcpy(ring->data, data + first, len - first);
+
+    // release publishes the bytes together with the new tail
+    __atomic_store_n(&ring->tail, ring->tail + len, __ATOMIC_RELEASE);
+    pcm_ring_notify(ring);
+    return len;
+}
+
+void pcm_ring_set_eof(pcm_ring* ring) {
+    __atomic_store_n(&ring->eof, 1, __ATOMIC_RELEASE);
+    pcm_ring_notify(ring);
+}
+
+size_t pcm_ring_read(pcm_ring* ring, uint8_t* data, size_t len) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t available = tail - ring->head;
+    if (len > available) {
+        len = available;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    size_t offset = ring->head % ring->capacity;
+    size_t first = ring->capacity - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, ring->data + offset, first);
+    memcpy(data + first, ring->data, len - first);
+
+    __atomic_store_n(&ring->head, ring->head + len, __ATOMIC_RELEASE);
+    pcm_ring_notify(ring);
+    return len;
+}
+
+int pcm_ring_is_eof(pcm_ring* ring) {
+    // eof is stored after the final write, so reading it first guarantees we see that tail
+    int eof = __atomic_load_n(&ring->eof, __ATOMIC_ACQUIRE);
+    return eof && ring->head == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+size_t pcm_ring_size(pcm_ring* ring) {
+    size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return tail - head;
+}
+
+void pcm_ring_reset(pcm_ring* ring) {
+    ring->head = 0;
+    ring->tail = 0;
+    ring->eof = 0;
+}
+
+void pcm_ring_free(pcm_ring* ring) {
+    if (ring->data) {
+        pthread_cond_destroy(&ring->moved);
+        pthread_mutex_destroy(&ring->lock);
+    }
+    free(ring->data);
+    memset(ring, 0, sizeof(pcm_ring));
+}
@@ -0,0 +1,216 @@
+#include "playlist.h"
+
+#define PLAYLIST_INITIAL_HASHES 128
+
+// FNV-1a, with 0 moved out of the way because it marks an empty slot
+static uint64_t playlist_hash(const char* url) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char* p = (const unsigned char*)url; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+int playlist_init(playlist* pl) {
+    memset(pl, 0, sizeof(playlist));
+
+    pl->hashes = calloc(PLAYLIST_INITIAL_HASHES, sizeof(uint64_t));
+    if (!pl->hashes) {
+        return -1;
+    }
+    pl->hash_capacity = PLAYLIST_INITIAL_HASHES;
+    return 0;
+}
+
+// linear probing; returns the slot holding `hash` or the empty slot where it would go
+static size_t playlist_hash_slot(const uint64_t* hashes, size_t capacity, uint64_t hash) {
+    size_t mask = capacity - 1;
+    size_t slot = (size_t)hash & mask;
+    while (hashes[slot] && hashes[slot] != hash) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int playlist_hash_grow(playlist* pl) {
+    size_t capacity = pl->hash_capacity * 2;
+    uint64_t* hashes = calloc(capacity, sizeof(uint64_t));
+    if (!hashes) {
+        return -1;
+    }
+    for (size_t i = 0; i < pl->hash_capacity; i++) {
+        if (pl->hashes[i]) {
+            hashes[playlist_hash_slot(hashes, capacity, pl->hashes[i])] = pl->hashes[i];
+        }
+    }
+    free(pl->hashes);
+    pl->hashes = hashes;
+    pl->hash_capacity = capacity;
+    return 0;
+}
+
+// frees segments and chunks behind the trim point, once no reader can still be using them
+static void playlist_reclaim(playlist* pl) {
+    size_t first = __atomic_load_n(&pl->first, __ATOMIC_SEQ_CST);
+    if (first <= pl->reclaimed) {
+        return;
+    }
+    // a reader that registers after this check sees the new first and stays away from it
+    if (__atomic_load_n(&pl->readers, __ATOMIC_SEQ_CST) != 0) {
+        return; // try again on the next push
+    }
+
+    for (size_t seg = pl->reclaimed / PLAYLIST_SEGMENT_SIZE; seg < first / PLAYLIST_SEGMENT_SIZE; seg++) {
+        free(pl->segments[seg]);
+        pl->segments[seg] = NULL;
+    }
+
+    // strings are stored in index order, so a chunk is free once its newest entry is trimmed.
+    // the newest chunk is kept for the next push even when it is empty
+    while (pl->oldest && pl->oldest != pl->newest && pl->oldest->last_index < first) {
+        playlist_chunk* chunk = pl->oldest;
+        pl->oldest = chunk->next;
+        pl->arena_bytes -= chunk->capacity;
+        free(chunk);
+    }
+    pl->reclaimed = first;
+}
+
+// copies the URL into the newest chunk, starting a new one when it doesn't fit
+static const char* playlist_arena_store(playlist* pl, const char* url, size_t len) {
+    playlist_chunk* chunk = pl->newest;
+    if (!chunk || chunk->capacity - chunk->used < len + 1) {
+        size_t capacity = len + 1 > PLAYLIST_CHUNK_SIZE ? len + 1 : PLAYLIST_CHUNK_SIZE;
+        chunk = malloc(sizeof(playlist_chunk) + capacity);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = NULL;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        if (pl->newest) {
+            pl->newest->next = chunk;
+        } else {
+            pl->oldest = chunk;
+        }
+        pl->newest = chunk;
+        pl->arena_bytes += capacity;
+    }
+
+    char* copy = chunk->data + chunk->used;
+    memcpy(copy, url, len + 1);
+    chunk->used += len + 1;
+    chunk->last_index = pl->size;
+    return copy;
+}
+
+int playlist_push_unique(playlist* pl, const char* url) {
+    playlist_reclaim(pl);
+
+    uint64_t hash = playlist_hash(url);
+    size_t slot = playlist_hash_slot(pl->hashes, pl->hash_capacity, hash);
+    if (pl->hashes[slot]) {
+        return 0;
+    }
+
+    // keep the set at most half full so probes stay short
+    if ((pl->hash_count + 1) * 2 > pl->hash_capacity) {
+        if (playlist_hash_grow(pl) < 0) {
+            return -1;
+        }
+        slot = playlist_hash_slot(pl->hashes, pl->hash_capacity, hash);
+    }
+
+    size_t index = pl->size; // only this thread writes size
+    size_t seg = index / PLAYLIST_SEGMENT_SIZE;
+    if (seg >= PLAYLIST_MAX_SEGMENTS) {
+        return -1;
+    }
+    if (!pl->segments[seg]) {
+        playlist_segment* segment = malloc(sizeof(playlist_segment));
+        if (!segment) {
+            return -1;
+        }
+        // published together with the size below
+        pl->segments[seg] = segment;
+    }
+
+    const char* copy = playlist_arena_store(pl, url, strlen(url));
+    if (!copy) {
+        return -1;
+    }
+
+    pl->hashes[slot] = hash;
+    pl->hash_count++;
+    pl->segments[seg]->urls[index % PLAYLIST_SEGMENT_SIZE] = copy;
+
+    // release: a reader that sees the new size also sees the segment and the string
+    __atomic_store_n(&pl->size, index + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void playlist_read_begin(playlist* pl) {
+    __atomic_add_fetch(&pl->readers, 1, __ATOMIC_SEQ_CST);
+}
+
+void playlist_read_end(playlist* pl) {
+    __atomic_sub_fetch(&pl->readers, 1, __ATOMIC_RELEASE);
+}
+
+const char* playlist_get(playlist* pl, size_t index) {
+    size_t size = __atomic_load_n(&pl->size, __ATOMIC_ACQUIRE);
+    if (index < __atomic_load_n(&pl->first, __ATOMIC_SEQ_CST) || index >= size) {
+        return NULL;
+    }
+    return pl->segments[index / PLAYLIST_SEGMENT_SIZE]->urls[index % PLAYLIST_SEGMENT_SIZE];
+}
+
+char* playlist_dup(playlist* pl, size_t index) {
+    playlist_read_begin(pl);
+    const char* url = playlist_get(pl, index);
+    char* copy = NULL;
+    if (url) {
+        size_t len = strlen(url);
+        copy = malloc(len + 1);
+        if (copy) {
+            memcpy(copy, url, len + 1);
+        }
+    }
+    playlist_read_end(pl);
+    return copy;
+}
+
+size_t playlist_size(playlist* pl) {
+    return __atomic_load_n(&pl->size, __ATOMIC_ACQUIRE);
+}
+
+size_t playlist_first(playlist* pl) {
+    return __atomic_load_n(&pl->first, __ATOMIC_ACQUIRE);
+}
+
+void playlist_trim(playlist* pl, size_t index) {
+    size_t size = __atomic_load_n(&pl->size, __ATOMIC_ACQUIRE);
+    if (index > size) {
+        index = size;
+    }
+    // only grows, and the writer frees what it leaves behind
+    size_t first = __atomic_load_n(&pl->first, __ATOMIC_RELAXED);
+    while (index > first &&
+           !__atomic_compare_exchange_n(&pl->first, &first, index, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+}
+
+void playlist_free(playlist* pl) {
+    playlist_chunk* chunk = pl->oldest;
+    while (chunk) {
+        playlist_chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    for (size_t seg = 0; seg < PLAYLIST_MAX_SEGMENTS; seg++) {
+        free(pl->segments[seg]);
+    }
+    free(pl->hashes);
+    memset(pl, 0, sizeof(playlist));
+}
@@ -0,0 +1,98 @@
+#define _POSIX_C_SOURCE 200809L
+#include "event_loop.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+static int event_loop_add(struct event_loop* loop, int fd, uint32_t tag) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = tag;
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+int event_loop_init(struct event_loop* loop, int input_fd) {
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (loop->epoll_fd < 0 || loop->notify_fd < 0 || loop->timer_fd < 0) {
+        perror("event loop");
+        event_loop_cleanup(loop);
+        return -1;
+    }
+
+    if ((input_fd >= 0 && event_loop_add(loop, input_fd, EVENT_INPUT) < 0) ||
+        event_loop_add(loop, loop->notify_fd, EVENT_NOTIFY) < 0 ||
+        event_loop_add(loop, loop->timer_fd, EVENT_TIMER) < 0) {
+        perror("epoll_ctl");
+        event_loop_cleanup(loop);
+        return -1;
+    }
+    return 0;
+}
+
+// safe from any thread; wakes a pending event_loop_wait()
+void event_loop_notify(struct event_loop* loop) {
+    uint64_t one = 1;
+    if (loop->notify_fd >= 0 && write(loop->notify_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+// one-shot deadline `seconds` from now; a deadline already due fires right away
+int event_loop_arm_timer(struct event_loop* loop, double seconds) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (seconds < 1e-6) {
+        seconds = 1e-6; // an all-zero it_value would disarm the timer instead
+    }
+    spec.it_value.tv_sec = (time_t)seconds;
+    spec.it_value.tv_nsec = (long)((seconds - spec.it_value.tv_sec) * 1000000000);
+    return timerfd_settime(loop->timer_fd, 0, &spec, NULL);
+}
+
+void event_loop_disarm_timer(struct event_loop* loop) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    timerfd_settime(loop->timer_fd, 0, &spec, NULL);
+}
+
+// sleeps until something is ready and returns the EVENT_* bits, 0 on timeout, -1 on error.
+// notify and timer counters are drained here; input is left for notcurses to read
+int event_loop_wait(struct event_loop* loop, int timeout_ms) {
+    struct epoll_event events[3];
+    int count = epoll_wait(loop->epoll_fd, events, 3, timeout_ms);
+    if (count < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        perror("epoll_wait");
+        return -1;
+    }
+
+    int ready = 0;
+    uint64_t counter;
+    for (int i = 0; i < count; i++) {
+        ready |= (int)events[i].data.u32;
+    }
+    if ((ready & EVENT_NOTIFY) && read(loop->notify_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+        perror("eventfd read");
+    }
+    if ((ready & EVENT_TIMER) && read(loop->timer_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+        perror("timerfd read");
+    }
+    return ready;
+}
+
+void event_loop_cleanup(struct event_loop* loop) {
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    if (loop->notify_fd >= 0) close(loop->notify_fd);
+    if (loop->timer_fd >= 0) close(loop->timer_fd);
+    loop->epoll_fd = loop->notify_fd = loop->timer_fd = -1;
+}
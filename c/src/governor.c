@@ -0,0 +1,195 @@
+#include "include/video_player.h"
+
+#define GOVERNOR_WINDOW 15       // frames per decision, about half a second
+#define GOVERNOR_BUDGET 0.75     // share of the frame interval blit + render may take
+#define GOVERNOR_HEADROOM 0.5    // below this share of the next level's interval, try it
+#define GOVERNOR_UP_WINDOWS 4    // good windows in a row before stepping up
+#define GOVERNOR_MAX_UP_WINDOWS 64
+#define GOVERNOR_SETTLE_WINDOWS 60 // stable this long and failed step ups are forgiven
+
+static int governor_blitter_ok(struct notcurses* nc, ncblitter_e blitter) {
+    switch (blitter) {
+    case NCBLIT_PIXEL: return notcurses_canpixel(nc);
+    case NCBLIT_3x2: return notcurses_cansextant(nc);
+    case NCBLIT_2x2: return notcurses_canquadrant(nc);
+    default: return 1;
+    }
+}
+
+static void governor_add_level(struct quality_governor* governor, ncblitter_e blitter, int scale, int fps_divisor) {
+    if (governor->level_count < GOVERNOR_MAX_LEVELS) {
+        struct quality_level* level = &governor->levels[governor->level_count++];
+        level->blitter = blitter;
+        level->scale = scale;
+        level->fps_divisor = fps_divisor;
+    }
+}
+
+// the ladder runs from `best` through every cheaper blitter the terminal has, each at full and
+// three-quarter size, then half size and finally half the frame rate on the cheapest one
+void governor_init(struct app_state* app, ncblitter_e best) {
+    struct quality_governor* governor = &app->governor;
+    memset(governor, 0, sizeof(struct quality_governor));
+    pthread_mutex_init(&governor->mutex, NULL);
+    governor->enabled = app->config.governor;
+    governor->up_windows = GOVERNOR_UP_WINDOWS;
+
+    static const ncblitter_e order[] = { NCBLIT_PIXEL, NCBLIT_3x2, NCBLIT_2x2, NCBLIT_1x1 };
+    int started = 0;
+    ncblitter_e cheapest = best;
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        started |= order[i] == best;
+        if (!started || !governor_blitter_ok(app->nc, order[i])) continue;
+        governor_add_level(governor, order[i], 100, 1);
+        governor_add_level(governor, order[i], 75, 1);
+        cheapest = order[i];
+    }
+    if (governor->level_count == 0) {
+        governor_add_level(governor, best, 100, 1); // not one we know, leave it alone
+        cheapest = best;
+    }
+    governor_add_level(governor, cheapest, 50, 1);
+    governor_add_level(governor, cheapest, 50, 2);
+
+    app->blitter = governor->levels[0].blitter;
+}
+
+static void governor_level_name(const struct quality_level* level, char* name, size_t len) {
+    snprintf(name, len, "%s %d%%%s", notcurses_str_blitter(level->blitter), level->scale,
+             level->fps_divisor > 1 ? " 1/2fps" : "");
+}
+
+static void governor_change(struct app_state* app, int to, double frame_cost, double budget) {
+    struct quality_governor* governor = &app->governor;
+
+    pthread_mutex_lock(&governor->mutex);
+    struct governor_decision* decision = &governor->log[governor->changes % GOVERNOR_LOG];
+    decision->time = get_time_in_seconds() - app->metrics.start_time;
+    decision->from = governor->level;
+    decision->to = to;
+    decision->frame_ms = frame_cost * 1000;
+    decision->budget_ms = budget * 1000;
+    governor->changes++;
+    governor->level = to;
+    pthread_mutex_unlock(&governor->mutex);
+
+    // the next frame redraws the background and lays the plane out for the new blitter and size
+    app->blitter = governor->levels[to].blitter;
+    app->layout_changed = true;
+    governor->skip = 0;
+    governor->good_windows = 0;
+    governor->stable_windows = 0;
+}
+
+// called after every rendered frame with what its blit and render took
+void governor_frame(struct app_state* app, struct video_player* player, double cost) {
+    struct quality_governor* governor = &app->governor;
+    if (!governor->enabled || player->frame_duration <= 0) {
+        return;
+    }
+
+    ncstats stats;
+    if (governor->frames == 0) {
+        notcurses_stats(app->nc, &stats);
+        governor->bytes_start = stats.raster_bytes;
+        governor->writeout_ns_start = stats.writeout_ns;
+    }
+    governor->cost += cost;
+    if (++governor->frames < GOVERNOR_WINDOW) {
+        return;
+    }
+
+    notcurses_stats(app->nc, &stats);
+    double frame_cost = governor->cost / governor->frames;
+    uint64_t window_bytes = stats.raster_bytes - governor->bytes_start;
+    uint64_t writeout_ns = stats.writeout_ns - governor->writeout_ns_start;
+    // the UDS thread reads these for stats, so they change together under the lock
+    pthread_mutex_lock(&governor->mutex);
+    governor->frame_cost = frame_cost;
+    governor->frame_bytes = (double)window_bytes / governor->frames;
+    governor->write_rate = writeout_ns ? window_bytes * 1e9 / writeout_ns : 0.0;
+    pthread_mutex_unlock(&governor->mutex);
+    governor->frames = 0;
+    governor->cost = 0.0;
+
+    const struct quality_level* level = &governor->levels[governor->level];
+    double budget = player->frame_duration * level->fps_divisor * GOVERNOR_BUDGET;
+
+    if (frame_cost > budget && governor->level + 1 < governor->level_count) {
+        // a step up that fails straight away means the last level was the right one, wait longer next time
+        if (governor->last_was_up && governor->stable_windows <= 2 && governor->up_windows < GOVERNOR_MAX_UP_WINDOWS) {
+            governor->up_windows *= 2;
+        }
+        governor->last_was_up = 0;
+        governor_change(app, governor->level + 1, frame_cost, budget);
+        return;
+    }
+
+    governor->stable_windows++;
+    if (governor->stable_windows >= GOVERNOR_SETTLE_WINDOWS) {
+        governor->up_windows = GOVERNOR_UP_WINDOWS;
+    }
+
+    // the level above renders more, so it needs real headroom at its own frame interval
+    if (governor->level > 0) {
+        const struct quality_level* up = &governor->levels[governor->level - 1];
+        double up_budget = player->frame_duration * up->fps_divisor;
+        if (frame_cost < up_budget * GOVERNOR_HEADROOM) {
+            if (++governor->good_windows >= governor->up_windows) {
+                governor->last_was_up = 1;
+                governor_change(app, governor->level - 1, frame_cost, budget);
+            }
+        } else {
+            governor->good_windows = 0;
+        }
+    }
+}
+
+// at a reduced frame rate, 1 for frames that should be skipped instead of rendered
+int governor_skip_frame(struct app_state* app) {
+    struct quality_governor* governor = &app->governor;
+    if (!governor->enabled || governor->levels[governor->level].fps_divisor <= 1) {
+        return 0;
+    }
+    if (governor->skip > 0) {
+        governor->skip--;
+        return 1;
+    }
+    governor->skip = governor->levels[governor->level].fps_divisor - 1;
+    return 0;
+}
+
+int governor_scale(struct app_state* app) {
+    if (!app->governor.enabled || app->governor.level_count == 0) {
+        return 100;
+    }
+    return app->governor.levels[app->governor.level].scale;
+}
+
+// "governor": {...} section of the stats reply, decisions oldest first
+void governor_format_json(struct quality_governor* governor, FILE* out) {
+    char name[64];
+
+    pthread_mutex_lock(&governor->mutex);
+    governor_level_name(&governor->levels[governor->level], name, sizeof(name));
+    fprintf(out, "\"governor\": {\"enabled\": %s, \"level\": %d, \"levels\": %d, \"quality\": \"%s\", "
+                 "\"frame_ms\": %.2f, \"bytes_per_frame\": %.0f, \"write_mb_s\": %.2f, \"changes\": %d, \"decisions\": [",
+            governor->enabled ? "true" : "false", governor->level, governor->level_count, name,
+            governor->frame_cost * 1000, governor->frame_bytes, governor->write_rate / 1e6, governor->changes);
+
+    int first = governor->changes > GOVERNOR_LOG ? governor->changes - GOVERNOR_LOG : 0;
+    for (int i = first; i < governor->changes; i++) {
+        struct governor_decision* decision = &governor->log[i % GOVERNOR_LOG];
+        char from[64];
+        governor_level_name(&governor->levels[decision->from], from, sizeof(from));
+        governor_level_name(&governor->levels[decision->to], name, sizeof(name));
+        fprintf(out, "%s{\"t\": %.1f, \"from\": \"%s\", \"to\": \"%s\", \"frame_ms\": %.2f, \"budget_ms\": %.2f}",
+                i > first ? ", " : "", decision->time, from, name, decision->frame_ms, decision->budget_ms);
+    }
+    fprintf(out, "]}");
+    pthread_mutex_unlock(&governor->mutex);
+}
+
+void governor_cleanup(struct quality_governor* governor) {
+    pthread_mutex_destroy(&governor->mutex);
+}
@@ -8,24 +8,13 @@ int check_page_size(struct app_state* app) {
         const char* warning = "Terminal size is too small for display.";
         ncplane_putstr_yx(app->stdplane, start_row, 1, warning);
 
-        int periods = 0;
-
+        const char* instruction = "Press any key to exit...";
+        ncplane_putstr_yx(app->stdplane, start_row + 1, 1, instruction);
         notcurses_render(app->nc);
 
-        // wait for any key
+        // wait for any key, blocking instead of redrawing on a timer
         ncinput ni;
-        while (!notcurses_get_nblock(app->nc, &ni)){
-            char* instruction = "Press any key to exit";
-
-            ncplane_putstr_yx(app->stdplane, start_row + 1, 1, instruction);
-            ncplane_putstr_yx(app->stdplane, start_row + 1, 1 + strlen(instruction), "       "); // clear previous dots
-            for (int i = 0; i < periods/5; i++) {
-                ncplane_putstr_yx(app->stdplane, start_row + 1, 1 + strlen(instruction) + i, ".");
-            }
-            periods = (periods + 1) % 40; // cycle through 0-3
-            notcurses_render(app->nc);
-            nanosleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 100000000}, NULL); // 100ms
-        }
+        notcurses_get_blocking(app->nc, &ni);
         notcurses_stop(app->nc);
     }
     return 1;
@@ -24,19 +24,43 @@ int app_init(struct app_state* app) {
         return -1;
     }
 
-    notcurses_term_dim_yx(app->nc, &app->rows, &app->cols);
-    app->blitter = graphics_detect_support(app->nc);
-
-    if (pthread_mutex_init(&app->video_list_mutex, NULL) != 0) {
-        fprintf(stderr, "Error initializing video list mutex\n");
+    // the main thread sleeps in epoll on terminal input, UDS notifications and frame deadlines
+    if (event_loop_init(&app->events, notcurses_inputready_fd(app->nc)) < 0) {
+        fprintf(stderr, "Error initializing event loop\n");
         notcurses_stop(app->nc);
         return -1;
     }
 
+    notcurses_term_dim_yx(app->nc, &app->rows, &app->cols);
+
+    config_load(&app->config);
+    app->debug_panel = app->config.debug_panel;
+
+    // starts at the best blitter the terminal has and steps down from there under load
+    governor_init(app, graphics_detect_support(app->nc));
+
+    // libao keeps global driver state, initialize it once for the whole process
+    ao_initialize();
+    app->audio_out.rate = app->config.audio_rate;
+    app->audio_out.channels = app->config.audio_channels;
+    app->audio_out.bits = app->config.audio_bits;
+
+    // a broken cache directory only costs us the cache, not playback
+    if (media_cache_init(&app->cache, app->config.cache_dir, app->config.cache_bytes) < 0) {
+        fprintf(stderr, "Continuing without media cache\n");
+    }
+
+    // restored before the UDS thread exists, it becomes the session's and the playlist's writer after this
+    if (app->config.resume && session_open(&app->session, app->config.cache_dir) == 0) {
+        app->video_index = session_restore(&app->session, app->video_list, &app->cache,
+                                          app->config.playlist_history, app->config.session_ttl);
+    } else {
+        app->session.fd = -1;
+    }
+
     // initialize and start the UDS server
     if (uds_server_init(&app->server) < 0) {
         fprintf(stderr, "Error initializing UDS server\n");
-        pthread_mutex_destroy(&app->video_list_mutex);
         notcurses_stop(app->nc);
         return -1;
     }
@@ -47,7 +71,6 @@ int app_init(struct app_state* app) {
     if (uds_server_start(&app->server) < 0) {
         fprintf(stderr, "Error starting UDS server\n");
         uds_server_cleanup(&app->server);
-        pthread_mutex_destroy(&app->video_list_mutex);
         notcurses_stop(app->nc);
         return -1;
     }
@@ -56,14 +79,32 @@ int app_init(struct app_state* app) {
 }
 
 void app_cleanup(struct app_state* app) {
-    // stop and cleanup the UDS server
-    // uds_server_cleanup(&app->server); UDS SERVER CLEANUP IS BREAKING AGAIN TODO
-    
-    // destroy the video list mutex
-    pthread_mutex_destroy(&app->video_list_mutex);
+    // stop and cleanup the UDS server; the eventfd wakes its thread, so this no longer hangs on a blocked recv
+    uds_server_cleanup(&app->server);
     
+    // nothing appends to the session once the server thread is gone
+    session_close(&app->session);
+
+    // the shared audio device outlives every reel, close it before libao shuts down
+    audio_output_close(&app->audio_out);
+
+    // flush the cache index so access order survives a restart
+    media_cache_cleanup(&app->cache);
+
     free(app->video_list);
 
+    if (app->video_plane) {
+        ncplane_destroy(app->video_plane);
+        app->video_plane = NULL;
+    }
+    info_panel_cleanup(app);
+    if (app->background_plane) {
+        ncplane_destroy(app->background_plane);
+        app->background_plane = NULL;
+    }
+
+    event_loop_cleanup(&app->events);
+
     if (app->nc) {
         notcurses_stop(app->nc);
     }
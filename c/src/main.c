@@ -1,63 +1,132 @@
 #include "video_player.h"
-#include "vector.h"
 
-int main() {
+#define APP_MAX_PLAY_FAILURES 3 // reels in a row that open but can't start before giving up
+
+// sleeps until the UDS thread signals or a key arrives; q (or a broken wait) quits
+static void app_wait_events(struct app_state* app) {
+    int ready = event_loop_wait(&app->events, -1);
+    if (ready < 0 || ((ready & EVENT_INPUT) && input_check_quit(app->nc))) {
+        app->quit = true;
+    }
+}
+
+// moves past a reel that cannot be played, e.g. one whose signed URL expired while it sat in a
+// restored session, and waits for the fetcher if that was the last one
+static void app_skip_reel(struct app_state* app) {
+    app->video_index++;
+    uds_server_request_fetch(&app->server);
+    while (!app->quit && playlist_size(app->video_list) <= (size_t)app->video_index) {
+        app_wait_events(app);
+    }
+}
+
+// the one teardown for every exit after app_init, so a failed start releases what a normal quit does.
+// the UDS thread goes first, so nothing pushes into the playlist while it is torn down
+static void app_shutdown(struct app_state* app) {
+    uds_server_stop(&app->server);
+    preloader_cleanup(&app->preloader);
+    playlist_free(app->video_list);
+    app_cleanup(app);
+
+    ao_shutdown();
+
+    stats_dump(&app->governor, app->config.stats_file);
+    governor_cleanup(&app->governor);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return bench_run(argc - 2, argv + 2);
+    }
+
     struct app_state app = {0};
-    struct video_player player = {0};
+    app.metrics.start_time = get_time_in_seconds();
+    stats_init();
 
-    app.video_list = malloc(sizeof(string_vector));
-    vector_init(app.video_list);
+    app.video_list = malloc(sizeof(playlist));
+    if (!app.video_list || playlist_init(app.video_list) < 0) {
+        fprintf(stderr, "Failed to allocate playlist\n");
+        return EXIT_FAILURE;
+    }
     if (app_init(&app) < 0) {
         return EXIT_FAILURE;
     }
+
+    // the UDS server is already up and asks the client for reels as soon as it says hello; with the
+    // preloader running too, the first reels are fetched, opened and primed behind the home page
+    if (preloader_init(&app.preloader, &app) < 0) {
+        app_shutdown(&app);
+        return EXIT_FAILURE;
+    }
+    preloader_update(&app.preloader, app.video_index - 1);
+
     // home page before video
     show_home_page(&app);
+    app.metrics.enter_time = get_time_in_seconds();
 
     notcurses_term_dim_yx(app.nc, &app.rows, &app.cols);
     notcurses_render(app.nc);
     video_plane_load(&app);
 
-    // wait for Python client to connect
-    while (1) {
-        if (app.server.client_connected) {
-            break;
-        }
-        usleep(100000); // sleep 100ms
-    }
-    
-    // now send fetch command to connected Python client
-    uds_server_send(&app.server, "fetch");
-    
-    while (1) {
-        pthread_mutex_lock(&app.video_list_mutex);
-        size_t video_list_size = app.video_list->size;
-        pthread_mutex_unlock(&app.video_list_mutex);
-        if (video_list_size == 0) { // dont begin the app until we have videos
-            usleep(100000); // 100ms
-            continue;
-        }
-        break;
+    // a restored session can start right away; otherwise wait for the Python client, which is
+    // asked for reels as soon as it says hello and wakes us when they arrive
+    while (!app.quit && playlist_size(app.video_list) <= (size_t)app.video_index) {
+        app_wait_events(&app);
     }
 
+    int play_failures = 0;
     while (!app.quit) {
 
-        pthread_mutex_lock(&app.video_list_mutex);
-        const char* current_video = vector_get(app.video_list, app.video_index);
-        pthread_mutex_unlock(&app.video_list_mutex);
+        // swap in a reel the preloader already opened, otherwise open it cold. either way the
+        // preloader's window now starts after this reel
+        int loading;
+        struct video_player* player = preloader_take(&app.preloader, app.video_index, &loading);
+        if (loading) {
+            app_wait_events(&app); // the preloader notifies when it is done, q still quits meanwhile
+            continue;
+        }
+        if (player) {
+            app.metrics.preload_hits++;
+        } else {
+            app.metrics.preload_misses++;
+
+            char* current_copy = playlist_dup(app.video_list, app.video_index);
 
-        if (video_load(&player, current_video) < 0) {
-            app_cleanup(&app);
-            return EXIT_FAILURE;
+            player = calloc(1, sizeof(struct video_player));
+            if (!player || video_load(&app, player, current_copy, app.config.packet_memory_bytes) < 0) {
+                free(current_copy);
+                free(player);
+                app_skip_reel(&app);
+                continue;
+            }
+            free(current_copy);
+        }
+
+        // forget URLs far behind the current reel; scrolling back stops at the oldest one kept
+        if (app.video_index > app.config.playlist_history) {
+            playlist_trim(app.video_list, app.video_index - app.config.playlist_history);
         }
-        video_play(&app, &player);
-        video_cleanup(&player);
-    }
 
-    vector_free(app.video_list);
-    video_cleanup(&player);
-    app_cleanup(&app);
+        session_set_position(&app.session, app.video_index);
+        int played = video_play(&app, player);
+        video_cleanup(player);
+        free(player);
 
-    ao_shutdown();
+        // it failed before taking any input, so the index still points at it and the next pass
+        // would only try again. one reel is skipped; several in a row point at the terminal or
+        // the machine rather than the reels
+        if (played < 0) {
+            if (++play_failures >= APP_MAX_PLAY_FAILURES) {
+                app_shutdown(&app);
+                fprintf(stderr, "Failed to start %d reels in a row, giving up\n", play_failures);
+                return EXIT_FAILURE;
+            }
+            app_skip_reel(&app);
+        } else {
+            play_failures = 0;
+        }
+    }
 
+    app_shutdown(&app);
     return EXIT_SUCCESS;
 }
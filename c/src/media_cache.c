@@ -0,0 +1,287 @@
+#include "include/video_player.h"
+#include <sys/stat.h>
+#include <errno.h>
+#include <dirent.h>
+#include <signal.h>
+
+#define MEDIA_CACHE_INDEX_MAGIC "reels-cache 1"
+#define MEDIA_CACHE_PART_MAX_AGE (60 * 60) // seconds without a write before a live pid's part is abandoned
+
+static int media_cache_mkdirs(const char* dir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s", dir);
+
+    for (char* p = path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+            *p = '/';
+        }
+    }
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+static void media_cache_entry_path(const struct media_cache* cache, uint64_t key, char* path, size_t path_len) {
+    snprintf(path, path_len, "%s/%016llx.media", cache->dir, (unsigned long long)key);
+}
+
+static struct cache_entry* media_cache_find(struct media_cache* cache, uint64_t key) {
+    for (size_t i = 0; i < cache->count; i++) {
+        if (cache->entries[i].key == key) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static int media_cache_add(struct media_cache* cache, uint64_t key, uint64_t size, uint64_t last_access) {
+    if (cache->count >= cache->capacity) {
+        size_t capacity = cache->capacity ? cache->capacity * 2 : 64;
+        struct cache_entry* entries = realloc(cache->entries, capacity * sizeof(struct cache_entry));
+        if (!entries) return -1;
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    cache->entries[cache->count].key = key;
+    cache->entries[cache->count].size = size;
+    cache->entries[cache->count].last_access = last_access;
+    cache->count++;
+    cache->total_bytes += size;
+    return 0;
+}
+
+static void media_cache_remove_at(struct media_cache* cache, size_t i) {
+    char path[PATH_MAX];
+    media_cache_entry_path(cache, cache->entries[i].key, path, sizeof(path));
+    unlink(path); // an open reader keeps its descriptor, the space is freed when it closes
+
+    cache->total_bytes -= cache->entries[i].size;
+    cache->entries[i] = cache->entries[cache->count - 1];
+    cache->count--;
+}
+
+// written to a temporary file and renamed so a crash never leaves a torn index
+static void media_cache_save_index(struct media_cache* cache) {
+    char path[PATH_MAX], tmp_path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", cache->dir, MEDIA_CACHE_INDEX_NAME);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/%s.tmp", cache->dir, MEDIA_CACHE_INDEX_NAME);
+
+    FILE* fp = fopen(tmp_path, "w");
+    if (!fp) return;
+
+    fprintf(fp, "%s\n", MEDIA_CACHE_INDEX_MAGIC);
+    for (size_t i = 0; i < cache->count; i++) {
+        fprintf(fp, "%016llx %llu %llu\n",
+                (unsigned long long)cache->entries[i].key,
+                (unsigned long long)cache->entries[i].size,
+                (unsigned long long)cache->entries[i].last_access);
+    }
+
+    if (fclose(fp) == 0 && rename(tmp_path, path) == 0) {
+        cache->dirty = 0;
+    } else {
+        unlink(tmp_path);
+    }
+}
+
+static void media_cache_load_index(struct media_cache* cache) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", cache->dir, MEDIA_CACHE_INDEX_NAME);
+
+    FILE* fp = fopen(path, "r");
+    if (!fp) return;
+
+    char line[128];
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, MEDIA_CACHE_INDEX_MAGIC, strlen(MEDIA_CACHE_INDEX_MAGIC)) != 0) {
+        fclose(fp);
+        return;
+    }
+
+    unsigned long long key, size, last_access;
+    while (fscanf(fp, "%llx %llu %llu", &key, &size, &last_access) == 3) {
+        // only trust entries whose file is still there with the recorded size
+        char media_path[PATH_MAX];
+        struct stat st;
+        media_cache_entry_path(cache, key, media_path, sizeof(media_path));
+        if (stat(media_path, &st) != 0 || (uint64_t)st.st_size != size) {
+            cache->dirty = 1;
+            continue;
+        }
+        if (media_cache_find(cache, key)) continue;
+        if (media_cache_add(cache, key, size, last_access) < 0) break;
+        if (last_access > cache->clock) cache->clock = last_access;
+    }
+    fclose(fp);
+}
+
+// a part file is stale once the process that wrote it is gone (its pid is in the name) or it
+// has not been written to for a while; another instance's live downloads are left alone
+static int media_cache_part_stale(const char* path, const char* name, time_t now) {
+    unsigned long long key;
+    int pid;
+    unsigned counter;
+    if (sscanf(name, "%16llx.%d.%u.part", &key, &pid, &counter) != 3 || pid <= 0 || pid == (int)getpid()) {
+        return 1; // not ours to guess about, or left behind by an earlier process with our pid
+    }
+    if (kill(pid, 0) != 0 && errno == ESRCH) {
+        return 1;
+    }
+    struct stat st;
+    return stat(path, &st) == 0 && now - st.st_mtime > MEDIA_CACHE_PART_MAX_AGE;
+}
+
+// part files belong to downloads that never finished, e.g. the player was killed mid-reel
+static void media_cache_remove_parts(struct media_cache* cache) {
+    DIR* dir = opendir(cache->dir);
+    if (!dir) return;
+
+    time_t now = time(NULL);
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != NULL) {
+        size_t len = strlen(ent->d_name);
+        if (len > 5 && strcmp(ent->d_name + len - 5, ".part") == 0) {
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", cache->dir, ent->d_name);
+            if (media_cache_part_stale(path, ent->d_name, now)) {
+                unlink(path);
+            }
+        }
+    }
+    closedir(dir);
+}
+
+// drops least recently used entries until the cache fits its budget, sparing `keep`
+static void media_cache_evict(struct media_cache* cache, uint64_t keep) {
+    while (cache->total_bytes > cache->max_bytes && cache->count > 0) {
+        size_t oldest = cache->count;
+        for (size_t i = 0; i < cache->count; i++) {
+            if (cache->entries[i].key == keep) continue;
+            if (oldest == cache->count || cache->entries[i].last_access < cache->entries[oldest].last_access) {
+                oldest = i;
+            }
+        }
+        if (oldest == cache->count) break;
+        media_cache_remove_at(cache, oldest);
+        cache->dirty = 1;
+    }
+}
+
+int media_cache_init(struct media_cache* cache, const char* dir, uint64_t max_bytes) {
+    memset(cache, 0, sizeof(struct media_cache));
+
+    if (!dir || !*dir || max_bytes == 0) {
+        return 0; // caching disabled
+    }
+
+    snprintf(cache->dir, sizeof(cache->dir), "%s", dir);
+    cache->max_bytes = max_bytes;
+
+    if (media_cache_mkdirs(cache->dir) < 0) {
+        fprintf(stderr, "Failed to create cache directory '%s': %s\n", cache->dir, strerror(errno));
+        return -1;
+    }
+
+    if (pthread_mutex_init(&cache->mutex, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize cache mutex\n");
+        return -1;
+    }
+
+    media_cache_remove_parts(cache);
+    media_cache_load_index(cache);
+    media_cache_evict(cache, 0);
+    if (cache->dirty) {
+        media_cache_save_index(cache);
+    }
+
+    cache->enabled = 1;
+    return 0;
+}
+
+// FNV-1a over the URL's host and path; the scheme goes, and so do the query and fragment,
+// since the signature in the query rotates while the media stays the same. the same path on
+// two hosts can be two different files, so the host stays in
+uint64_t media_cache_key(const char* url) {
+    const char* start = url;
+    const char* scheme = strstr(url, "://");
+    if (scheme) {
+        start = scheme + 3;
+    }
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char* p = start; *p && *p != '?' && *p != '#'; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+int media_cache_lookup(struct media_cache* cache, uint64_t key, char* path, size_t path_len) {
+    if (!cache->enabled) return 0;
+
+    pthread_mutex_lock(&cache->mutex);
+    struct cache_entry* entry = media_cache_find(cache, key);
+    if (entry) {
+        entry->last_access = ++cache->clock;
+        cache->dirty = 1;
+        media_cache_entry_path(cache, key, path, path_len);
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    return entry != NULL;
+}
+
+// unique per download so a preload and a cold open of the same reel never share a part file
+int media_cache_part_path(struct media_cache* cache, uint64_t key, char* path, size_t path_len) {
+    if (!cache->enabled) return -1;
+
+    pthread_mutex_lock(&cache->mutex);
+    unsigned counter = cache->part_counter++;
+    pthread_mutex_unlock(&cache->mutex);
+
+    snprintf(path, path_len, "%s/%016llx.%d.%u.part", cache->dir, (unsigned long long)key, (int)getpid(), counter);
+    return 0;
+}
+
+int media_cache_commit(struct media_cache* cache, uint64_t key, const char* part_path, uint64_t size) {
+    if (!cache->enabled) return -1;
+
+    char path[PATH_MAX];
+    media_cache_entry_path(cache, key, path, sizeof(path));
+
+    pthread_mutex_lock(&cache->mutex);
+
+    if (media_cache_find(cache, key) || size > cache->max_bytes) {
+        pthread_mutex_unlock(&cache->mutex);
+        unlink(part_path);
+        return 0;
+    }
+
+    if (rename(part_path, path) != 0 || media_cache_add(cache, key, size, ++cache->clock) < 0) {
+        pthread_mutex_unlock(&cache->mutex);
+        unlink(part_path);
+        return -1;
+    }
+
+    media_cache_evict(cache, key);
+    media_cache_save_index(cache);
+
+    pthread_mutex_unlock(&cache->mutex);
+    return 0;
+}
+
+void media_cache_cleanup(struct media_cache* cache) {
+    if (!cache->enabled) return;
+
+    pthread_mutex_lock(&cache->mutex);
+    if (cache->dirty) {
+        media_cache_save_index(cache);
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->count = 0;
+    cache->enabled = 0;
+    pthread_mutex_destroy(&cache->mutex);
+}
@@ -0,0 +1,379 @@
+#include "include/video_player.h"
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+// records that [start, end) of the part file now holds real data, merging neighbours
+static void media_io_add_range(struct media_io* io, int64_t start, int64_t end) {
+    int i = 0;
+    while (i < io->range_count) {
+        struct byte_range* r = &io->ranges[i];
+        if (end < r->start || start > r->end) {
+            i++;
+            continue;
+        }
+        // overlapping or touching, absorb it and look again
+        if (r->start < start) start = r->start;
+        if (r->end > end) end = r->end;
+        io->ranges[i] = io->ranges[--io->range_count];
+        i = 0;
+    }
+
+    if (io->range_count == MEDIA_CACHE_MAX_RANGES) {
+        io->overflowed = 1;
+        return;
+    }
+    io->ranges[io->range_count].start = start;
+    io->ranges[io->range_count].end = end;
+    io->range_count++;
+}
+
+static int media_io_complete(const struct media_io* io) {
+    int64_t size = io->size >= 0 ? io->size : io->eof_pos;
+    if (size <= 0 || io->overflowed) return 0;
+
+    for (int i = 0; i < io->range_count; i++) {
+        if (io->ranges[i].start == 0 && io->ranges[i].end >= size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// tee into the part file at the same offset, a failed write just means no cache entry
+static void media_io_tee(struct media_io* io, const uint8_t* buf, int n, int64_t pos) {
+    if (io->fd < 0) {
+        return;
+    }
+    if (pwrite(io->fd, buf, n, pos) == n) {
+        media_io_add_range(io, pos, pos + n);
+    } else {
+        io->overflowed = 1;
+    }
+}
+
+static int media_io_aborted(const struct media_io* io) {
+    return io->int_cb.callback && io->int_cb.callback(io->int_cb.opaque);
+}
+
+// the read-ahead thread: the only one touching the source, the part file and the ranges while it runs
+static void* media_io_fetch_thread(void* arg) {
+    struct media_io* io = (struct media_io*)arg;
+
+    pthread_mutex_lock(&io->mutex);
+    while (!io->stop) {
+        if (io->seek_to >= 0) {
+            int64_t target = io->seek_to;
+            unsigned generation = io->generation;
+            pthread_mutex_unlock(&io->mutex);
+
+            // the http protocol turns this into a range request
+            int64_t result = avio_seek(io->source, target, SEEK_SET);
+
+            pthread_mutex_lock(&io->mutex);
+            if (generation == io->generation) {
+                io->seek_to = -1;
+                io->fetch_pos = target;
+                io->fetch_error = result < 0 ? (int)result : 0;
+                pthread_cond_broadcast(&io->cond);
+            }
+            continue;
+        }
+
+        size_t space = io->ring_size - io->ring_fill;
+        if (io->fetch_error || space == 0) {
+            pthread_cond_wait(&io->cond, &io->mutex);
+            continue;
+        }
+
+        // the free part of the ring after the data, up to where it wraps; the reader never looks there
+        size_t tail = (io->ring_head + io->ring_fill) % io->ring_size;
+        size_t len = io->ring_size - tail < space ? io->ring_size - tail : space;
+        if (len > MEDIA_IO_FETCH_SIZE) len = MEDIA_IO_FETCH_SIZE;
+        int64_t pos = io->fetch_pos;
+        unsigned generation = io->generation;
+        pthread_mutex_unlock(&io->mutex);
+
+        int n = avio_read_partial(io->source, io->ring + tail, (int)len);
+        if (n > 0) {
+            media_io_tee(io, io->ring + tail, n, pos);
+        }
+
+        pthread_mutex_lock(&io->mutex);
+        if (generation != io->generation) {
+            continue; // a seek came in while reading, this data is for the old position
+        }
+        if (n > 0) {
+            io->ring_fill += n;
+            io->fetch_pos += n;
+            io->fetched_bytes += n;
+        } else if (n == 0 || n == AVERROR_EOF) {
+            io->eof_pos = pos;
+            io->fetch_error = AVERROR_EOF;
+        } else {
+            io->fetch_error = n;
+        }
+        pthread_cond_broadcast(&io->cond);
+    }
+    pthread_mutex_unlock(&io->mutex);
+    return NULL;
+}
+
+static int media_io_ring_read(struct media_io* io, uint8_t* buf, int buf_size) {
+    pthread_mutex_lock(&io->mutex);
+    while (io->ring_fill == 0 && (!io->fetch_error || io->seek_to >= 0)) {
+        if (media_io_aborted(io)) {
+            pthread_mutex_unlock(&io->mutex);
+            return AVERROR_EXIT;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += MEDIA_IO_WAIT_NS;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&io->cond, &io->mutex, &deadline);
+    }
+
+    if (io->ring_fill == 0) {
+        int error = io->fetch_error;
+        pthread_mutex_unlock(&io->mutex);
+        return error;
+    }
+
+    size_t n = io->ring_fill < (size_t)buf_size ? io->ring_fill : (size_t)buf_size;
+    size_t first = io->ring_size - io->ring_head < n ? io->ring_size - io->ring_head : n;
+    memcpy(buf, io->ring + io->ring_head, first);
+    memcpy(buf + first, io->ring, n - first);
+    io->ring_head = (io->ring_head + n) % io->ring_size;
+    io->ring_fill -= n;
+    io->ring_start += n;
+    io->pos = io->ring_start;
+    pthread_cond_broadcast(&io->cond);
+    pthread_mutex_unlock(&io->mutex);
+    return (int)n;
+}
+
+// inside what is already fetched the ring just skips ahead; anything else goes to the thread
+static int64_t media_io_ring_seek(struct media_io* io, int64_t target) {
+    pthread_mutex_lock(&io->mutex);
+    if (io->seek_to < 0 && target >= io->ring_start && target <= io->ring_start + (int64_t)io->ring_fill) {
+        size_t skip = (size_t)(target - io->ring_start);
+        io->ring_head = (io->ring_head + skip) % io->ring_size;
+        io->ring_fill -= skip;
+    } else {
+        io->seek_to = target;
+        io->generation++;
+        io->ring_head = 0;
+        io->ring_fill = 0;
+        io->fetch_error = 0;
+        io->fetch_seeks++;
+    }
+    io->ring_start = target;
+    io->pos = target;
+    pthread_cond_broadcast(&io->cond);
+    pthread_mutex_unlock(&io->mutex);
+    return target;
+}
+
+static int media_io_read(void* opaque, uint8_t* buf, int buf_size) {
+    struct media_io* io = (struct media_io*)opaque;
+
+    if (!io->source) {
+        ssize_t n = read(io->fd, buf, buf_size);
+        if (n < 0) return AVERROR(errno);
+        if (n == 0) return AVERROR_EOF;
+        io->pos += n;
+        return (int)n;
+    }
+    if (io->thread_running) {
+        return media_io_ring_read(io, buf, buf_size);
+    }
+
+    int n = avio_read_partial(io->source, buf, buf_size);
+    if (n == 0 || n == AVERROR_EOF) {
+        io->eof_pos = io->pos;
+        return AVERROR_EOF;
+    }
+    if (n < 0) return n;
+
+    media_io_tee(io, buf, n, io->pos);
+    io->pos += n;
+    return n;
+}
+
+static int64_t media_io_seek(void* opaque, int64_t offset, int whence) {
+    struct media_io* io = (struct media_io*)opaque;
+
+    if (whence & AVSEEK_SIZE) {
+        return io->size >= 0 ? io->size : AVERROR(ENOSYS);
+    }
+    whence &= ~AVSEEK_FORCE;
+
+    if (io->thread_running) {
+        int64_t target = offset;
+        if (whence == SEEK_CUR) {
+            target = io->pos + offset;
+        } else if (whence == SEEK_END) {
+            if (io->size < 0) return AVERROR(ENOSYS);
+            target = io->size + offset;
+        }
+        if (target < 0) return AVERROR(EINVAL);
+        return media_io_ring_seek(io, target);
+    }
+
+    int64_t result;
+    if (!io->source) {
+        result = lseek(io->fd, offset, whence);
+        if (result < 0) return AVERROR(errno);
+    } else {
+        // the http protocol turns this into a range request
+        result = avio_seek(io->source, offset, whence);
+        if (result < 0) return result;
+    }
+    io->pos = result;
+    return result;
+}
+
+// network reads move to a thread that stays up to `size` bytes ahead of the demuxer
+static int media_io_start_readahead(struct media_io* io, size_t size) {
+    io->ring = malloc(size);
+    if (!io->ring) {
+        fprintf(stderr, "Failed to allocate read-ahead buffer\n");
+        return -1;
+    }
+    io->ring_size = size;
+
+    if (pthread_mutex_init(&io->mutex, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize read-ahead mutex\n");
+        return -1;
+    }
+    if (pthread_cond_init(&io->cond, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize read-ahead condition variable\n");
+        pthread_mutex_destroy(&io->mutex);
+        return -1;
+    }
+    int ret = pthread_create(&io->thread, NULL, media_io_fetch_thread, io);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to create read-ahead thread: %s\n", strerror(ret));
+        pthread_cond_destroy(&io->cond);
+        pthread_mutex_destroy(&io->mutex);
+        return -1;
+    }
+    io->thread_running = 1;
+    return 0;
+}
+
+// remote reels are read through here whether or not the cache is on; readahead 0 reads synchronously
+int media_io_open(struct media_io* io, struct media_cache* cache, const char* url, const AVIOInterruptCB* int_cb,
+                  size_t readahead) {
+    memset(io, 0, sizeof(struct media_io));
+    io->cache = cache;
+    io->fd = -1;
+    io->size = -1;
+    io->eof_pos = -1;
+    io->seek_to = -1;
+    if (int_cb) {
+        io->int_cb = *int_cb;
+    }
+    io->key = media_cache_key(url);
+
+    char path[PATH_MAX];
+    if (media_cache_lookup(cache, io->key, path, sizeof(path))) {
+        io->fd = open(path, O_RDONLY);
+        if (io->fd >= 0) {
+            struct stat st;
+            if (fstat(io->fd, &st) == 0) {
+                io->size = st.st_size;
+            }
+        }
+        // evicted between the lookup and the open, fall through to the network
+    }
+
+    if (io->fd < 0) {
+        // the demuxer seeks to a trailing moov and back, keep-alive saves a reconnect each way
+        AVDictionary* options = NULL;
+        av_dict_set(&options, "multiple_requests", "1", 0);
+        int ret = avio_open2(&io->source, url, AVIO_FLAG_READ, int_cb, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to open URL: %s\n", av_err2str(ret));
+            return -1;
+        }
+        io->size = avio_size(io->source);
+
+        if (media_cache_part_path(cache, io->key, io->part_path, sizeof(io->part_path)) == 0) {
+            io->fd = open(io->part_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (io->fd < 0) {
+                io->part_path[0] = '\0';
+            }
+        }
+    }
+
+    unsigned char* buffer = av_malloc(MEDIA_IO_BUFFER_SIZE);
+    if (!buffer) {
+        media_io_close(io);
+        return -1;
+    }
+
+    io->avio = avio_alloc_context(buffer, MEDIA_IO_BUFFER_SIZE, 0, io, media_io_read, NULL, media_io_seek);
+    if (!io->avio) {
+        av_free(buffer);
+        media_io_close(io);
+        return -1;
+    }
+    io->avio->seekable = io->source ? io->source->seekable : 1;
+
+    if (io->source && readahead > 0 && media_io_start_readahead(io, readahead) < 0) {
+        fprintf(stderr, "Continuing without read-ahead\n"); // reads stay on the demux thread
+    }
+
+    return 0;
+}
+
+static void media_io_stop_readahead(struct media_io* io) {
+    if (io->thread_running) {
+        pthread_mutex_lock(&io->mutex);
+        io->stop = 1;
+        pthread_cond_broadcast(&io->cond);
+        pthread_mutex_unlock(&io->mutex);
+
+        // a read blocked on the network returns once the demuxer's interrupt callback fires
+        pthread_join(io->thread, NULL);
+        io->thread_running = 0;
+        pthread_cond_destroy(&io->cond);
+        pthread_mutex_destroy(&io->mutex);
+    }
+    free(io->ring);
+    io->ring = NULL;
+}
+
+void media_io_close(struct media_io* io) {
+    media_io_stop_readahead(io);
+
+    if (io->avio) {
+        av_freep(&io->avio->buffer);
+        avio_context_free(&io->avio);
+    }
+
+    if (io->source) {
+        avio_closep(&io->source);
+    }
+
+    if (io->fd >= 0) {
+        close(io->fd);
+        io->fd = -1;
+    }
+
+    // the download only becomes a cache entry if every byte of the file was seen
+    if (io->part_path[0]) {
+        if (media_io_complete(io)) {
+            int64_t size = io->size >= 0 ? io->size : io->eof_pos;
+            media_cache_commit(io->cache, io->key, io->part_path, (uint64_t)size);
+        } else {
+            unlink(io->part_path);
+        }
+        io->part_path[0] = '\0';
+    }
+}
@@ -0,0 +1,238 @@
+#include "include/video_player.h"
+
+int preloader_init(struct preloader* preloader, struct app_state* app) {
+    if (!preloader || !app) return -1;
+
+    memset(preloader, 0, sizeof(struct preloader));
+    preloader->app = app;
+    preloader->slot_count = app->config.preload_count;
+    preloader->current_index = -1;
+
+    if (preloader->slot_count == 0) {
+        return 0; // preloading disabled
+    }
+
+    preloader->memory_per_reel = app->config.preload_memory_bytes / preloader->slot_count;
+
+    preloader->slots = calloc(preloader->slot_count, sizeof(struct preload_slot));
+    if (!preloader->slots) {
+        fprintf(stderr, "Failed to allocate preload slots\n");
+        return -1;
+    }
+    for (int i = 0; i < preloader->slot_count; i++) {
+        preloader->slots[i].video_index = -1;
+    }
+
+    if (pthread_mutex_init(&preloader->mutex, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize preload mutex\n");
+        free(preloader->slots);
+        return -1;
+    }
+    if (pthread_cond_init(&preloader->cond, NULL) != 0) {
+        fprintf(stderr, "Failed to initialize preload condition variable\n");
+        pthread_mutex_destroy(&preloader->mutex);
+        free(preloader->slots);
+        return -1;
+    }
+
+    preloader->is_running = 1;
+    if (pthread_create(&preloader->thread, NULL, preloader_thread_func, preloader) != 0) {
+        fprintf(stderr, "Failed to create preload thread\n");
+        preloader->is_running = 0;
+        pthread_cond_destroy(&preloader->cond);
+        pthread_mutex_destroy(&preloader->mutex);
+        free(preloader->slots);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int preloader_wanted(struct preloader* preloader, int video_index) {
+    return video_index > preloader->current_index &&
+           video_index <= preloader->current_index + preloader->slot_count;
+}
+
+static void preloader_release_player(struct video_player* player) {
+    if (player) {
+        video_cleanup(player);
+        free(player);
+    }
+}
+
+// called with the mutex held; returns a slot to fill and the index to fill it with, or NULL
+static struct preload_slot* preloader_next_job(struct preloader* preloader, int* video_index) {
+    int list_size = (int)playlist_size(preloader->app->video_list);
+
+    for (int index = preloader->current_index + 1;
+         index <= preloader->current_index + preloader->slot_count && index < list_size;
+         index++) {
+        int have = 0;
+        for (int i = 0; i < preloader->slot_count; i++) {
+            if (preloader->slots[i].video_index == index) {
+                have = 1;
+                break;
+            }
+        }
+        if (have) continue;
+
+        for (int i = 0; i < preloader->slot_count; i++) {
+            if (preloader->slots[i].state == PRELOAD_EMPTY) {
+                *video_index = index;
+                return &preloader->slots[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+void* preloader_thread_func(void* arg) {
+    struct preloader* preloader = (struct preloader*)arg;
+
+    pthread_mutex_lock(&preloader->mutex);
+    while (preloader->is_running) {
+        // drop reels that fell out of the window, the user scrolled past or away from them
+        struct video_player* stale = NULL;
+        for (int i = 0; i < preloader->slot_count; i++) {
+            struct preload_slot* slot = &preloader->slots[i];
+            if (slot->state != PRELOAD_EMPTY && slot->state != PRELOAD_LOADING &&
+                !preloader_wanted(preloader, slot->video_index)) {
+                stale = slot->player;
+                slot->player = NULL;
+                slot->video_index = -1;
+                slot->state = PRELOAD_EMPTY;
+                break;
+            }
+        }
+        if (stale) {
+            pthread_mutex_unlock(&preloader->mutex);
+            preloader_release_player(stale);
+            pthread_mutex_lock(&preloader->mutex);
+            continue;
+        }
+
+        int video_index = -1;
+        struct preload_slot* slot = preloader_next_job(preloader, &video_index);
+        if (!slot) {
+            preloader->work_pending = 0;
+            while (preloader->is_running && !preloader->work_pending) {
+                pthread_cond_wait(&preloader->cond, &preloader->mutex);
+            }
+            continue;
+        }
+
+        slot->video_index = video_index;
+        slot->state = PRELOAD_LOADING;
+        pthread_mutex_unlock(&preloader->mutex);
+
+        char* url_copy = playlist_dup(preloader->app->video_list, video_index);
+
+        // open, probe and decode the first frame; audio packets pile up in the demux queue
+        struct video_player* player = calloc(1, sizeof(struct video_player));
+        int ok = player && url_copy && video_load(preloader->app, player, url_copy, preloader->memory_per_reel) == 0;
+        if (ok) {
+            ok = video_prime(player) == 0;
+        }
+        free(url_copy);
+        if (!ok && player) {
+            preloader_release_player(player);
+            player = NULL;
+        }
+
+        pthread_mutex_lock(&preloader->mutex);
+        slot->player = player;
+        slot->state = ok ? PRELOAD_READY : PRELOAD_FAILED;
+        if (preloader->take_waiting) {
+            preloader->take_waiting = 0;
+            event_loop_notify(&preloader->app->events);
+        }
+    }
+    pthread_mutex_unlock(&preloader->mutex);
+
+    return NULL;
+}
+
+void preloader_update(struct preloader* preloader, int current_index) {
+    if (!preloader->is_running) return;
+
+    pthread_mutex_lock(&preloader->mutex);
+    preloader->current_index = current_index;
+    preloader->work_pending = 1;
+    pthread_cond_broadcast(&preloader->cond);
+    pthread_mutex_unlock(&preloader->mutex);
+}
+
+// new URLs arrived, the window may have room to fill now
+void preloader_notify(struct preloader* preloader) {
+    if (!preloader->is_running) return;
+
+    pthread_mutex_lock(&preloader->mutex);
+    preloader->work_pending = 1;
+    pthread_cond_broadcast(&preloader->cond);
+    pthread_mutex_unlock(&preloader->mutex);
+}
+
+// the preloaded player for video_index, or NULL to open it cold. never blocks: a reel still being
+// opened sets *loading instead, and the event loop is notified once it is ready or failed
+struct video_player* preloader_take(struct preloader* preloader, int video_index, int* loading) {
+    *loading = 0;
+    if (!preloader->is_running) return NULL;
+
+    struct video_player* player = NULL;
+
+    pthread_mutex_lock(&preloader->mutex);
+    // claim the index by moving the window past it, so a miss opened cold here is never
+    // fetched a second time by the preload thread
+    preloader->current_index = video_index;
+    preloader->work_pending = 1;
+    pthread_cond_broadcast(&preloader->cond);
+
+    for (int i = 0; i < preloader->slot_count; i++) {
+        struct preload_slot* slot = &preloader->slots[i];
+        if (slot->video_index != video_index) continue;
+
+        // already on its way, waiting for it beats opening the same URL twice, but the wait
+        // happens in the caller's event loop so a key still gets through
+        if (slot->state == PRELOAD_LOADING) {
+            preloader->take_waiting = 1;
+            *loading = 1;
+            break;
+        }
+
+        if (slot->state == PRELOAD_READY) {
+            player = slot->player;
+        }
+        slot->player = NULL;
+        slot->video_index = -1;
+        slot->state = PRELOAD_EMPTY;
+        break;
+    }
+    pthread_mutex_unlock(&preloader->mutex);
+
+    if (player) {
+        // it is the playing reel now, give it the full packet budget back
+        demuxer_set_memory_limit(&player->demux, preloader->app->config.packet_memory_bytes);
+    }
+    return player;
+}
+
+void preloader_cleanup(struct preloader* preloader) {
+    if (!preloader->is_running) return;
+
+    pthread_mutex_lock(&preloader->mutex);
+    preloader->is_running = 0;
+    pthread_cond_broadcast(&preloader->cond);
+    pthread_mutex_unlock(&preloader->mutex);
+
+    pthread_join(preloader->thread, NULL);
+
+    for (int i = 0; i < preloader->slot_count; i++) {
+        preloader_release_player(preloader->slots[i].player);
+        preloader->slots[i].player = NULL;
+    }
+    free(preloader->slots);
+    preloader->slots = NULL;
+
+    pthread_cond_destroy(&preloader->cond);
+    pthread_mutex_destroy(&preloader->mutex);
+}
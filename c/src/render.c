@@ -1,4 +1,5 @@
 #include "include/video_player.h"
+#include <stdarg.h>
 
 ncblitter_e graphics_detect_support(struct notcurses* nc) {
     if (notcurses_canpixel(nc)) {
@@ -16,39 +17,153 @@ ncblitter_e graphics_detect_support(struct notcurses* nc) {
     }
 }
 
+// publishes the plane's size in blitter pixels so decoders can scale frames to it ahead of the blit
+static void video_output_size_update(struct app_state* app) {
+    unsigned rows, cols;
+    ncplane_dim_yx(app->video_plane, &rows, &cols);
+
+    uint64_t width = 0, height = 0;
+    switch (app->blitter) {
+    case NCBLIT_PIXEL: {
+        unsigned pixel_y, pixel_x;
+        ncplane_pixel_geom(app->video_plane, &pixel_y, &pixel_x, NULL, NULL, NULL, NULL);
+        width = pixel_x;
+        height = pixel_y;
+        break;
+    }
+    case NCBLIT_3x2: width = cols * 2; height = rows * 3; break;
+    case NCBLIT_2x2: width = cols * 2; height = rows * 2; break;
+    case NCBLIT_2x1: width = cols;     height = rows * 2; break;
+    case NCBLIT_1x1: width = cols;     height = rows;     break;
+    default: break; // unknown geometry, decoders keep the full size and notcurses scales
+    }
+
+    __atomic_store_n(&app->video_output_size, (width << 32) | height, __ATOMIC_RELEASE);
+}
+
+// sizes the persistent video plane to the current layout, creating it on first use.
+// every frame is blitted into this one plane instead of a fresh child plane per frame.
+// the governor can shrink it, the smaller plane stays centered in the full size one
+int video_output_plane_update(struct app_state* app) {
+    int scale = governor_scale(app);
+    int full_height = app->rows > 1 ? app->rows - 1 : 1;
+    int video_width = app->rows * 2 * 9 / 16 * scale / 100;
+    int video_height = full_height * scale / 100;
+    int video_x = (app->cols - video_width) / 2;
+    int video_y = 1 + (full_height - video_height) / 2;
+    if (video_width < 1) video_width = 1;
+    if (video_height < 1) video_height = 1;
+
+    if (!app->video_plane) {
+        // clears the "Fetching..." screen; created first, the background stays under the video
+        if (video_background_draw(app) < 0) {
+            return -1;
+        }
+
+        struct ncplane_options nopts = {
+            .y = video_y,
+            .x = video_x,
+            .rows = video_height,
+            .cols = video_width,
+            .name = "video",
+        };
+        app->video_plane = ncplane_create(app->stdplane, &nopts);
+        if (!app->video_plane) {
+            fprintf(stderr, "Error creating video plane\n");
+            return -1;
+        }
+
+        // let the gradient show through wherever the frame doesn't cover the plane
+        uint64_t base = 0;
+        ncchannels_set_fg_alpha(&base, NCALPHA_TRANSPARENT);
+        ncchannels_set_bg_alpha(&base, NCALPHA_TRANSPARENT);
+        ncplane_set_base(app->video_plane, "", 0, base);
+        video_output_size_update(app);
+        return 0;
+    }
+
+    unsigned cur_rows, cur_cols;
+    ncplane_dim_yx(app->video_plane, &cur_rows, &cur_cols);
+    if (cur_rows != (unsigned)video_height || cur_cols != (unsigned)video_width) {
+        if (ncplane_resize_simple(app->video_plane, video_height, video_width) < 0) {
+            fprintf(stderr, "Error resizing video plane\n");
+            return -1;
+        }
+    }
+    ncplane_move_yx(app->video_plane, video_y, video_x);
+    ncplane_erase(app->video_plane);
+    video_output_size_update(app);
+    return 0;
+}
+
 struct ncplane* video_render_frame(struct app_state* app, struct video_player* player) {
 
-    int video_width = app->rows * 2 * 9 / 16; 
+    // terminal was resized, redraw the background and fit the video plane to it
+    if (app->layout_changed || !app->video_plane) {
+        app->layout_changed = false;
+        if (video_background_draw(app) < 0 || video_output_plane_update(app) < 0 || info_panel_layout(app) < 0) {
+            return NULL;
+        }
+    }
+
     struct ncvisual_options vopts = {
-        .n = app->stdplane,
-        .scaling = NCSCALE_SCALE,
+        .n = app->video_plane,
+        .scaling = player->frame_prescaled ? NCSCALE_NONE : NCSCALE_SCALE,
         .blitter = app->blitter,
-        .flags = NCVISUAL_OPTION_CHILDPLANE | NCVISUAL_OPTION_NOINTERPOLATE,
-        .x = ((app->cols - video_width) / 2),
-        .y = 1,
+        .flags = NCVISUAL_OPTION_NOINTERPOLATE,
     };
 
+    double blit_start = get_time_in_seconds();
     struct ncplane* rendered_plane = ncvisual_blit(app->nc, player->ncv, &vopts);
     if (!rendered_plane) {
         fprintf(stderr, "Error rendering frame %d\n", player->frame_count);
         return NULL;
     }
+    double render_start = get_time_in_seconds();
+    app->metrics.blit_time_total += render_start - blit_start;
+    stats_record(STATS_BLIT, render_start - blit_start);
 
     if (player->frame_count % 10 == 0) {
         render_info_panel(app, player);
     }
 
+    // the info panel is drawn on the same pass, the render histogram includes it every tenth frame
+    double raster_start = get_time_in_seconds();
     if (notcurses_render(app->nc)) {
         fprintf(stderr, "Error rendering screen\n");
         return NULL;
     }
+    stats_record(STATS_RENDER, get_time_in_seconds() - raster_start);
+
+    double cost = get_time_in_seconds() - blit_start;
+    app->metrics.render_time_total += cost;
+    app->metrics.rendered_frames++;
+    governor_frame(app, player, cost);
 
     return rendered_plane;
 }
 
-int video_plane_load(struct app_state* app) {
-    ncplane_erase(app->stdplane);
+// instagram-style gradient behind the video and info panel. it has a plane of its own under
+// both, drawn only here (at start and on a layout change), so frames and panel updates never
+// write into the plane that holds it
+int video_background_draw(struct app_state* app) {
     notcurses_term_dim_yx(app->nc, &app->rows, &app->cols);
+    if (!app->background_plane) {
+        struct ncplane_options nopts = {
+            .rows = app->rows,
+            .cols = app->cols,
+            .name = "background",
+        };
+        app->background_plane = ncplane_create(app->stdplane, &nopts);
+        if (!app->background_plane) {
+            fprintf(stderr, "Error creating background plane\n");
+            return -1;
+        }
+    } else if (ncplane_resize_simple(app->background_plane, app->rows, app->cols) < 0) {
+        fprintf(stderr, "Error resizing background plane\n");
+        return -1;
+    }
+    ncplane_erase(app->background_plane);
 
     // instagram gradient
     uint64_t tl = NCCHANNELS_INITIALIZER(0x1a, 0x0f, 0x1a, 0x2d, 0x1b, 0x69);  // dark purple top-left
@@ -56,69 +171,238 @@ int video_plane_load(struct app_state* app) {
     uint64_t bl = NCCHANNELS_INITIALIZER(0x0a, 0x0a, 0x0a, 0x1a, 0x0f, 0x1a);  // very dark bottom-left
     uint64_t br = NCCHANNELS_INITIALIZER(0xfd, 0x1d, 0x1d, 0xf5, 0x6a, 0x00);  // orange-red bottom-right
 
-    ncplane_gradient(app->stdplane, 0, 0, app->rows, app->cols, " ", 0, tl, tr, bl, br);
+    ncplane_gradient(app->background_plane, 0, 0, app->rows, app->cols, " ", 0, tl, tr, bl, br);
 
     uint64_t text_channel = NCCHANNELS_INITIALIZER(0xf8, 0xbb, 0xd9, 0x1a, 0x0f, 0x1a);  // light pink fg, dark purple bg
-    ncplane_set_channels(app->stdplane, text_channel);
+    ncplane_set_channels(app->background_plane, text_channel);
+    return 0;
+}
+
+int video_plane_load(struct app_state* app) {
+    if (video_background_draw(app) < 0) {
+        return -1;
+    }
 
     const char* loading = "Fetching...";
     int loading_len = strlen(loading);
     int loading_x = (app->cols - loading_len) / 2;
     int loading_y = app->rows / 2;
-    ncplane_putstr_yx(app->stdplane, loading_y, loading_x, loading);
+    ncplane_putstr_yx(app->background_plane, loading_y, loading_x, loading);
 
     notcurses_render(app->nc);
     return 0;
 }
 
 
-int render_info_panel(struct app_state* app, struct video_player* player) {
-    int info_panel_width = 30;
+// the panel sits right of the video; videos are in 1.91:1 to 9:16, do 9:16 conversion and multiply by 2 for safety
+static int info_panel_x(struct app_state* app) {
+    int video_width = app->rows * 2 * 9 / 16;
+    return (app->cols - video_width) / 2 + video_width + 1;
+}
 
-    // videos are in 1.91:1 to 9:16, do 9:16 conversion and multiply by 2 for safety
-    int video_width = app->rows * 2 * 9 / 16; 
-    int video_location = (app->cols - video_width) / 2;
-    int video_location_width = video_location + video_width;
+#define INFO_CONTROLS_Y (2 + INFO_FIELDS + 1)
+#define INFO_DEBUG_Y (INFO_CONTROLS_Y + 10) // below the five control lines and their gaps
 
-    float current_time = (float)player->frame_count / DEFAULT_FPS;
-    int current_minutes = (int)current_time / 60;
-    int current_seconds = (int)current_time % 60;
+// titles and controls go on their own plane, drawn when it is created. the values sit on a
+// transparent plane above it, so the gradient on the background plane behind both is never touched again
+int info_panel_layout(struct app_state* app) {
+    if (!app->ui_plane) {
+        struct ncplane_options nopts = {
+            .y = 1,
+            .x = info_panel_x(app),
+            .rows = INFO_DEBUG_Y + 2 + INFO_DEBUG_FIELDS,
+            .cols = INFO_PANEL_WIDTH,
+            .name = "info",
+        };
+        app->ui_plane = ncplane_create(app->stdplane, &nopts);
+        if (!app->ui_plane) {
+            fprintf(stderr, "Error creating info panel plane\n");
+            return -1;
+        }
+
+        struct ncplane_options fopts = {
+            .y = 2,
+            .x = 0,
+            .rows = INFO_FIELDS,
+            .cols = INFO_PANEL_WIDTH,
+            .name = "info-fields",
+        };
+        app->info_plane = ncplane_create(app->ui_plane, &fopts);
+        if (!app->info_plane) {
+            fprintf(stderr, "Error creating info panel plane\n");
+            ncplane_destroy(app->ui_plane);
+            app->ui_plane = NULL;
+            return -1;
+        }
+
+        uint64_t base = 0;
+        ncchannels_set_fg_alpha(&base, NCALPHA_TRANSPARENT);
+        ncchannels_set_bg_alpha(&base, NCALPHA_TRANSPARENT);
+        uint64_t text_channel = NCCHANNELS_INITIALIZER(0xf8, 0xbb, 0xd9, 0x1a, 0x0f, 0x1a);  // light pink fg, dark purple bg
+        ncplane_set_base(app->ui_plane, "", 0, base);
+        ncplane_set_base(app->info_plane, "", 0, base);
+        ncplane_set_channels(app->ui_plane, text_channel);
+        ncplane_set_channels(app->info_plane, text_channel);
+        memset(app->info_fields, 0, sizeof(app->info_fields));
+
+        // video information
+        ncplane_putstr_yx(app->ui_plane, 0, 0, "VIDEO INFO");
+
+        // contorls, one empty line between each
+        int line = INFO_CONTROLS_Y;
+        ncplane_putstr_yx(app->ui_plane, line, 0, "CONTROLS");
+        line += 2;
+        ncplane_putstr_yx(app->ui_plane, line, 0, "q/Q - Quit");
+        line += 2;
+        ncplane_putstr_yx(app->ui_plane, line, 0, "␣ - Pause");
+        line += 2;
+        ncplane_putstr_yx(app->ui_plane, line, 0, "🔼🔽 - Scroll");
+        line += 2;
+        ncplane_putstr_yx(app->ui_plane, line, 0, "d - Debug");
+        return 0;
+    }
 
-    char info_lines[10][info_panel_width];
-    int line = 1;
+    // the info plane is bound to this one and follows it
+    ncplane_move_yx(app->ui_plane, 1, info_panel_x(app));
+    return 0;
+}
 
-    // video information
-    snprintf(info_lines[0], info_panel_width, "VIDEO INFO");
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[0]);
+// creates or removes the telemetry under the controls to match app->debug_panel. the title
+// goes on ui_plane and the values on their own plane, laid out like the video information
+static int info_panel_debug_layout(struct app_state* app) {
+    if (!app->debug_panel) {
+        if (app->debug_plane) {
+            ncplane_destroy(app->debug_plane);
+            app->debug_plane = NULL;
+            ncplane_erase_region(app->ui_plane, INFO_DEBUG_Y, 0, 1, INFO_PANEL_WIDTH);
+        }
+        return 0;
+    }
+    if (app->debug_plane) {
+        return 0;
+    }
 
-    line++; // empty line
+    struct ncplane_options dopts = {
+        .y = INFO_DEBUG_Y + 2,
+        .x = 0,
+        .rows = INFO_DEBUG_FIELDS,
+        .cols = INFO_PANEL_WIDTH,
+        .name = "info-debug",
+    };
+    app->debug_plane = ncplane_create(app->ui_plane, &dopts);
+    if (!app->debug_plane) {
+        fprintf(stderr, "Error creating info panel plane\n");
+        return -1;
+    }
 
-    snprintf(info_lines[1], info_panel_width, "File: %.20s", strrchr(player->filename, '/') ? strrchr(player->filename, '/') + 1 : player->filename);
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[1]);
+    uint64_t base = 0;
+    ncchannels_set_fg_alpha(&base, NCALPHA_TRANSPARENT);
+    ncchannels_set_bg_alpha(&base, NCALPHA_TRANSPARENT);
+    ncplane_set_base(app->debug_plane, "", 0, base);
+    ncplane_set_channels(app->debug_plane, NCCHANNELS_INITIALIZER(0xf8, 0xbb, 0xd9, 0x1a, 0x0f, 0x1a));
+    memset(app->debug_fields, 0, sizeof(app->debug_fields));
+    ncplane_putstr_yx(app->ui_plane, INFO_DEBUG_Y, 0, "DEBUG");
+    return 0;
+}
 
-    snprintf(info_lines[3], info_panel_width, "Time: %02d:%02d", current_minutes, current_seconds);
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[3]);
+// redraws line `row` of a values plane only when its text differs from what is on it
+static void info_panel_field(struct ncplane* plane, char (*fields)[INFO_PANEL_WIDTH], int row, const char* fmt, ...) {
+    char text[INFO_PANEL_WIDTH];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
 
-    line++;
+    if (strcmp(text, fields[row]) == 0) {
+        return;
+    }
+    memcpy(fields[row], text, sizeof(text));
+    ncplane_erase_region(plane, row, 0, 1, INFO_PANEL_WIDTH);
+    ncplane_putstr_yx(plane, row, 0, text);
+}
+
+// load, queue, audio and sync telemetry
+static void render_debug_fields(struct app_state* app, struct video_player* player) {
+    struct ncplane* plane = app->debug_plane;
+    char (*fields)[INFO_PANEL_WIDTH] = app->debug_fields;
+    int row = 0;
+
+    // scroll-to-first-frame of the last scroll, and how often the preloader had it ready
+    info_panel_field(plane, fields, row++, "Load: %4d ms (%d/%d hit)",
+                     (int)(app->metrics.last_scroll_to_first_frame * 1000),
+                     app->metrics.preload_hits, app->metrics.preload_hits + app->metrics.preload_misses);
 
-    // contorls
-    snprintf(info_lines[5], info_panel_width, "CONTROLS");
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[5]);
+    // Enter to first frame, and whether it came from a restored session
+    info_panel_field(plane, fields, row++, "Start: %4d ms (%s)",
+                     (int)(app->metrics.enter_to_first_frame * 1000), app->session.restored ? "resumed" : "cold");
 
-    line++; // empty line
+    info_panel_field(plane, fields, row++, "Queue: %llu under %llu over",
+                     (unsigned long long)player->frames.underruns, (unsigned long long)player->frames.overruns);
 
-    snprintf(info_lines[6], info_panel_width, "q/Q - Quit");
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[6]);
+    info_panel_field(plane, fields, row++, "Render: %.1f ms/frame",
+                     app->metrics.rendered_frames ? app->metrics.render_time_total * 1000 / app->metrics.rendered_frames : 0.0);
 
-    line++; // empty line
+    info_panel_field(plane, fields, row++, "Frames: %d drop %d late %d",
+                     player->frames_displayed, player->frames_dropped, player->frames_late);
 
-    snprintf(info_lines[7], info_panel_width, "␣ - Pause");
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[7]);
+    if (player->audio) {
+        // ring fill and device latency explain what the sync has to work with
+        info_panel_field(plane, fields, row++, "Audio: %2d%% %dms %llu under",
+                         (int)(player->audio->fill_level * 100), (int)(player->audio->device_latency * 1000),
+                         (unsigned long long)player->audio->underruns);
 
-    line++; // empty line
+        // master clock, smoothed drift, and how often it had to step in
+        info_panel_field(plane, fields, row++, "Sync: %s %+dms r%d s%d",
+                         sync_master_name(player->sync.master), (int)(player->sync.drift * 1000),
+                         player->sync.repeats, player->sync.resyncs);
+    }
 
-    snprintf(info_lines[8], info_panel_width, "🔼🔽 - Scroll");
-    ncplane_putstr_yx(app->stdplane, line++, video_location_width + 1, info_lines[8]);
+    // what the governor settled on, and how many times it changed its mind
+    if (app->governor.enabled) {
+        const struct quality_level* level = &app->governor.levels[app->governor.level];
+        info_panel_field(plane, fields, row++, "Quality: %s %d%% /%d c%d",
+                         notcurses_str_blitter(level->blitter), level->scale, level->fps_divisor, app->governor.changes);
+    }
+
+    // a reel without audio has fewer lines than the last one
+    while (row < INFO_DEBUG_FIELDS) {
+        info_panel_field(plane, fields, row++, "%s", "");
+    }
+}
+
+int render_info_panel(struct app_state* app, struct video_player* player) {
+    if (!app->info_plane && info_panel_layout(app) < 0) {
+        return -1;
+    }
+
+    float current_time = (float)player->sync.video_clock;
+    int current_minutes = (int)current_time / 60;
+    int current_seconds = (int)current_time % 60;
+
+    info_panel_field(app->info_plane, app->info_fields, 0, "File: %.20s", strrchr(player->filename, '/') ? strrchr(player->filename, '/') + 1 : player->filename);
+    info_panel_field(app->info_plane, app->info_fields, 1, "Time: %02d:%02d", current_minutes, current_seconds);
+
+    if (info_panel_debug_layout(app) < 0) {
+        return -1;
+    }
+    if (app->debug_plane) {
+        render_debug_fields(app, player);
+    }
 
     return 0;
 }
+
+void info_panel_cleanup(struct app_state* app) {
+    if (app->debug_plane) {
+        ncplane_destroy(app->debug_plane);
+        app->debug_plane = NULL;
+    }
+    if (app->info_plane) {
+        ncplane_destroy(app->info_plane);
+        app->info_plane = NULL;
+    }
+    if (app->ui_plane) {
+        ncplane_destroy(app->ui_plane);
+        app->ui_plane = NULL;
+    }
+}
@@ -0,0 +1,231 @@
+#include "include/video_player.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+int session_open(struct session* session, const char* dir) {
+    memset(session, 0, sizeof(struct session));
+    session->fd = -1;
+
+    if (!dir || !*dir) {
+        return 0; // nowhere to keep it, every start is a cold start
+    }
+
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create session directory '%s': %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, SESSION_FILE_NAME);
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open session file '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    // the file is sparse, only the header, the entries in use and their text take up space
+    struct stat st;
+    int fresh = fstat(fd, &st) != 0 || st.st_size != (off_t)sizeof(struct session_file);
+    if (fresh && ftruncate(fd, sizeof(struct session_file)) != 0) {
+        fprintf(stderr, "Failed to size session file '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    struct session_file* map = mmap(NULL, sizeof(struct session_file), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Failed to map session file '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    if (fresh || map->magic != SESSION_MAGIC || map->version != SESSION_VERSION ||
+        map->entry_count > SESSION_MAX_ENTRIES || map->text_used > SESSION_TEXT_BYTES) {
+        map->magic = SESSION_MAGIC;
+        map->version = SESSION_VERSION;
+        map->entry_count = 0;
+        map->text_used = 0;
+        map->current = 0;
+        map->watched = 0;
+    }
+
+    session->map = map;
+    session->fd = fd;
+    return 0;
+}
+
+// a crash can leave a half written entry behind, those are skipped rather than trusted
+static int session_entry_valid(const struct session_file* file, const struct session_entry* entry) {
+    return entry->length > 0 &&
+           (uint64_t)entry->offset + entry->length < file->text_used &&
+           file->text[entry->offset + entry->length] == '\0';
+}
+
+// an uncached reel streams from its saved URL, which is signed and stops working after a
+// while; a cached one plays from disk whatever its URL has become. `cached` may be NULL when
+// only usability matters, which saves the lookup for recent entries
+static int session_entry_usable(const struct session_file* file, const struct session_entry* entry,
+                                struct media_cache* cache, int64_t now, long ttl, int* cached) {
+    int fresh = now - entry->saved <= ttl;
+    if (fresh && !cached) {
+        return 1;
+    }
+    char path[PATH_MAX];
+    int hit = media_cache_lookup(cache, media_cache_key(file->text + entry->offset), path, sizeof(path));
+    if (cached) {
+        *cached = hit;
+    }
+    return hit || fresh;
+}
+
+// puts the saved reels back into the (empty) playlist and returns the index to start at:
+// the first unwatched reel that is already in the media cache, since it plays without the
+// network, otherwise the first unwatched one. uncached reels saved more than `ttl` seconds
+// ago are dropped, their URLs would only fail to open. the file is compacted to what was
+// restored while at it
+int session_restore(struct session* session, playlist* list, struct media_cache* cache, int history, long ttl) {
+    struct session_file* file = session->map;
+    if (!file) {
+        return 0;
+    }
+
+    int64_t now = (int64_t)time(NULL);
+    uint32_t count = file->entry_count;
+    int64_t resume = -1;
+    int64_t unwatched = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        const struct session_entry* entry = &file->entries[i];
+        if (entry->index < file->watched || !session_entry_valid(file, entry)) continue;
+        int cached;
+        if (!session_entry_usable(file, entry, cache, now, ttl, &cached)) continue;
+        if (unwatched < 0) {
+            unwatched = i;
+        }
+        if (cached) {
+            resume = i;
+            break;
+        }
+    }
+    if (resume < 0) {
+        resume = unwatched;
+    }
+
+    // the same history the main loop keeps behind the current reel, for scrolling back
+    uint32_t keep_from = resume >= 0 ? (uint32_t)resume : count;
+    keep_from = keep_from > (uint32_t)history ? keep_from - (uint32_t)history : 0;
+
+    // entries and their text only ever move towards the front, so this is done in place
+    int start = -1;
+    uint32_t kept = 0;
+    uint64_t text_used = 0;
+    for (uint32_t i = keep_from; i < count; i++) {
+        struct session_entry entry = file->entries[i];
+        if (!session_entry_valid(file, &entry) || !session_entry_usable(file, &entry, cache, now, ttl, NULL)) continue;
+
+        char* url = file->text + entry.offset;
+        if (playlist_push_unique(list, url) <= 0) continue;
+
+        size_t index = playlist_size(list) - 1;
+        if ((int64_t)i == resume) {
+            start = (int)index;
+        }
+
+        memmove(file->text + text_used, url, entry.length + 1);
+        file->entries[kept].index = index;
+        file->entries[kept].offset = (uint32_t)text_used;
+        file->entries[kept].length = entry.length;
+        file->entries[kept].saved = entry.saved;
+        text_used += entry.length + 1;
+        kept++;
+    }
+
+    file->text_used = text_used;
+    file->entry_count = kept;
+    if (start < 0) {
+        start = (int)playlist_size(list); // everything was watched, wait for the fetcher
+    }
+    file->current = (uint64_t)start;
+    file->watched = (uint64_t)start;
+
+    session->restored = (int)kept;
+    return start;
+}
+
+// drops what the playlist already trimmed; if that frees nothing, the oldest quarter goes
+static void session_compact(struct session_file* file, size_t first) {
+    uint32_t drop = 0;
+    while (drop < file->entry_count && file->entries[drop].index < first) {
+        drop++;
+    }
+    if (drop == 0) {
+        drop = file->entry_count / 4 + 1;
+    }
+    if (drop >= file->entry_count) {
+        file->entry_count = 0;
+        file->text_used = 0;
+        return;
+    }
+
+    uint32_t shift = file->entries[drop].offset;
+    uint32_t kept = file->entry_count - drop;
+    memmove(file->text, file->text + shift, file->text_used - shift);
+    memmove(file->entries, file->entries + drop, kept * sizeof(struct session_entry));
+    for (uint32_t i = 0; i < kept; i++) {
+        file->entries[i].offset -= shift;
+    }
+    file->text_used -= shift;
+    file->entry_count = kept;
+}
+
+// called by the playlist's writer right after it added `url` at `index`, so the disk write
+// (really a page cache write) happens on the UDS thread and never on the render path
+void session_append(struct session* session, const char* url, size_t index, size_t first) {
+    struct session_file* file = session->map;
+    if (!file) {
+        return;
+    }
+
+    size_t len = strlen(url);
+    if (len + 1 > SESSION_TEXT_BYTES / 4) {
+        return; // not a URL we need to remember
+    }
+    while (file->entry_count == SESSION_MAX_ENTRIES || file->text_used + len + 1 > SESSION_TEXT_BYTES) {
+        session_compact(file, first);
+    }
+
+    struct session_entry* entry = &file->entries[file->entry_count];
+    memcpy(file->text + file->text_used, url, len + 1);
+    entry->index = index;
+    entry->offset = (uint32_t)file->text_used;
+    entry->length = (uint32_t)len;
+    entry->saved = (int64_t)time(NULL);
+    file->text_used += len + 1;
+    file->entry_count++;
+}
+
+// main thread, once per reel. a few stores into the mapping, no syscall
+void session_set_position(struct session* session, size_t index) {
+    struct session_file* file = session->map;
+    if (!file) {
+        return;
+    }
+
+    file->current = index;
+    if (index + 1 > file->watched) {
+        file->watched = index + 1;
+    }
+}
+
+void session_close(struct session* session) {
+    if (session->map) {
+        munmap(session->map, sizeof(struct session_file));
+        session->map = NULL;
+    }
+    if (session->fd >= 0) {
+        close(session->fd);
+        session->fd = -1;
+    }
+}
@@ -0,0 +1,176 @@
+#include "include/video_player.h"
+
+// histograms are per thread so recording never takes a lock or shares a cache line.
+// they are process wide rather than hung off app_state because demux, decode and audio
+// threads only know their own reel. a thread's set is folded into `retired` when it exits
+struct stats_thread {
+    struct histogram metrics[STATS_METRIC_COUNT];
+    struct stats_thread* next;
+};
+
+static const char* stats_names[STATS_METRIC_COUNT] = {
+    "demux", "decode", "blit", "render", "audio_decode", "ao_play", "av_drift", "scroll_to_first_frame",
+    "enter_to_first_frame", "open_to_first_decode",
+};
+
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static int stats_key_ok;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct stats_thread* stats_threads;
+static struct histogram stats_retired[STATS_METRIC_COUNT];
+static double stats_start;
+
+static void stats_thread_exit(void* arg) {
+    struct stats_thread* thread = (struct stats_thread*)arg;
+
+    pthread_mutex_lock(&stats_mutex);
+    for (struct stats_thread** link = &stats_threads; *link; link = &(*link)->next) {
+        if (*link == thread) {
+            *link = thread->next;
+            break;
+        }
+    }
+    for (int i = 0; i < STATS_METRIC_COUNT; i++) {
+        histogram_merge(&stats_retired[i], &thread->metrics[i]);
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    free(thread);
+}
+
+static void stats_key_create(void) {
+    stats_key_ok = pthread_key_create(&stats_key, stats_thread_exit) == 0;
+}
+
+void stats_init(void) {
+    pthread_once(&stats_once, stats_key_create);
+    stats_start = get_time_in_seconds();
+}
+
+// first sample on this thread: register its histograms
+static struct stats_thread* stats_thread_register(void) {
+    pthread_once(&stats_once, stats_key_create);
+    if (!stats_key_ok) {
+        return NULL;
+    }
+
+    struct stats_thread* thread = calloc(1, sizeof(struct stats_thread));
+    if (!thread) {
+        return NULL;
+    }
+    if (pthread_setspecific(stats_key, thread) != 0) {
+        free(thread);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&stats_mutex);
+    thread->next = stats_threads;
+    stats_threads = thread;
+    pthread_mutex_unlock(&stats_mutex);
+    return thread;
+}
+
+void stats_record(enum stats_metric metric, double seconds) {
+    struct stats_thread* thread = stats_key_ok ? pthread_getspecific(stats_key) : NULL;
+    if (!thread) {
+        thread = stats_thread_register();
+        if (!thread) {
+            return;
+        }
+    }
+    histogram_record(&thread->metrics[metric], seconds > 0.0 ? (uint64_t)(seconds * 1e9) : 0);
+}
+
+// every thread's histograms merged, live ones included
+void stats_snapshot(struct histogram snapshot[STATS_METRIC_COUNT]) {
+    memset(snapshot, 0, sizeof(struct histogram) * STATS_METRIC_COUNT);
+
+    pthread_mutex_lock(&stats_mutex);
+    for (int i = 0; i < STATS_METRIC_COUNT; i++) {
+        histogram_merge(&snapshot[i], &stats_retired[i]);
+    }
+    for (struct stats_thread* thread = stats_threads; thread; thread = thread->next) {
+        for (int i = 0; i < STATS_METRIC_COUNT; i++) {
+            histogram_merge(&snapshot[i], &thread->metrics[i]);
+        }
+    }
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+// {"uptime_s": ..., "metrics": {"<name>": {"count", "mean_us", "p50_us", "p90_us", "p99_us",
+// "max_us", "buckets": [[upper_ns, count], ...]}}, "governor": {...}}, only non-empty buckets listed.
+// the governor section is left out without one. caller frees
+char* stats_format_json(struct quality_governor* governor, size_t* len) {
+    struct histogram* snapshot = malloc(sizeof(struct histogram) * STATS_METRIC_COUNT);
+    if (!snapshot) {
+        return NULL;
+    }
+    stats_snapshot(snapshot);
+
+    char* json = NULL;
+    size_t size = 0;
+    FILE* out = open_memstream(&json, &size);
+    if (!out) {
+        free(snapshot);
+        return NULL;
+    }
+
+    fprintf(out, "{\"uptime_s\": %.1f, \"metrics\": {", get_time_in_seconds() - stats_start);
+    for (int i = 0; i < STATS_METRIC_COUNT; i++) {
+        struct histogram* h = &snapshot[i];
+        fprintf(out, "%s\"%s\": {\"count\": %llu, \"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, "
+                     "\"p99_us\": %.1f, \"max_us\": %.1f, \"buckets\": [",
+                i ? ", " : "", stats_names[i], (unsigned long long)h->count,
+                h->count ? h->sum / 1e3 / h->count : 0.0,
+                histogram_percentile(h, 50) / 1e3, histogram_percentile(h, 90) / 1e3,
+                histogram_percentile(h, 99) / 1e3, h->max / 1e3);
+        int first = 1;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            if (!h->buckets[b]) continue;
+            fprintf(out, "%s[%llu, %llu]", first ? "" : ", ",
+                    (unsigned long long)histogram_bucket_upper(b), (unsigned long long)h->buckets[b]);
+            first = 0;
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "}");
+    if (governor) {
+        fprintf(out, ", ");
+        governor_format_json(governor, out);
+    }
+    fprintf(out, "}\n");
+
+    free(snapshot);
+    if (fclose(out) != 0) {
+        free(json);
+        return NULL;
+    }
+    if (len) {
+        *len = size;
+    }
+    return json;
+}
+
+// the same JSON the stats command returns, written once at exit; nothing happens without a path
+void stats_dump(struct quality_governor* governor, const char* path) {
+    if (!path || !*path) {
+        return;
+    }
+
+    size_t len = 0;
+    char* json = stats_format_json(governor, &len);
+    if (!json) {
+        fprintf(stderr, "Failed to format stats\n");
+        return;
+    }
+
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Failed to write stats to '%s': %s\n", path, strerror(errno));
+    } else {
+        fwrite(json, 1, len, fp);
+        fclose(fp);
+    }
+    free(json);
+}
@@ -0,0 +1,69 @@
+#include "include/video_player.h"
+
+static const char* sync_master_names[] = {
+    [SYNC_MASTER_AUDIO] = "audio",
+    [SYNC_MASTER_WALL] = "wall",
+};
+
+const char* sync_master_name(enum sync_master master) {
+    return sync_master_names[master];
+}
+
+// picks the clock for a new reel; following audio needs a reel that has some
+void sync_start(struct app_state* app, struct video_player* player) {
+    player->sync.master = app->config.sync_master;
+    if (player->sync.master == SYNC_MASTER_AUDIO && !player->audio) {
+        player->sync.master = SYNC_MASTER_WALL;
+    }
+    player->sync.drift = 0.0;
+    player->sync.repeats = 0;
+    player->sync.resyncs = 0;
+}
+
+// once per displayed frame. drift between the frame just shown and the audio clock is always
+// measured and recorded; with audio as the master it also steers the frame schedule, which
+// video_next_frame follows: a later schedule holds the current frame (a repeat), an earlier one
+// leaves frames overtaken and they are dropped
+void sync_update(struct video_player* player, double now) {
+    double audio_time;
+    if (!player->audio || !player->audio->is_playing || audio_clock_get(player->audio, now, &audio_time) < 0) {
+        return; // nothing to measure against yet, the schedule runs on the wall clock
+    }
+
+    double video_time = player->frame_pts - player->sync.start_pts;
+    double diff = video_time - audio_time;
+    player->sync.audio_clock = audio_time;
+    stats_record(STATS_AV_DRIFT, diff < 0 ? -diff : diff);
+
+    if (player->sync.master != SYNC_MASTER_AUDIO) {
+        player->sync.drift += SYNC_DRIFT_SMOOTHING * (diff - player->sync.drift);
+        return;
+    }
+
+    // a long underrun or a stalled decoder: catching up a frame at a time would take seconds
+    if (diff > SYNC_RESYNC_THRESHOLD || diff < -SYNC_RESYNC_THRESHOLD) {
+        player->sync.frame_timer += diff;
+        player->sync.drift = 0.0;
+        player->sync.resyncs++;
+        return;
+    }
+
+    // single readings jitter by the sink's chunk size, only a sustained drift is acted on
+    player->sync.drift += SYNC_DRIFT_SMOOTHING * (diff - player->sync.drift);
+
+    double threshold = player->frame_duration;
+    if (threshold < SYNC_THRESHOLD_MIN) threshold = SYNC_THRESHOLD_MIN;
+    if (threshold > SYNC_THRESHOLD_MAX) threshold = SYNC_THRESHOLD_MAX;
+
+    // at most a frame per correction, so a repeat or drop is never more than one frame
+    if (player->sync.drift > threshold) {
+        double hold = player->sync.drift < player->frame_duration ? player->sync.drift : player->frame_duration;
+        player->sync.frame_timer += hold;
+        player->sync.drift -= hold;
+        player->sync.repeats++;
+    } else if (player->sync.drift < -threshold) {
+        double skip = -player->sync.drift < player->frame_duration ? -player->sync.drift : player->frame_duration;
+        player->sync.frame_timer -= skip;
+        player->sync.drift += skip;
+    }
+}
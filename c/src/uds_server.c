@@ -8,9 +8,10 @@ int uds_server_init(struct uds_server* server) {
 
     memset(server, 0, sizeof(struct uds_server));
     server->server_fd = -1;
-    server->client_fd = -1;
+    server->epoll_fd = -1;
+    server->wake_fd = -1;
     server->is_running = 0;
-    server->client_connected = 0;
+    server->client_count = 0;
     server->app = NULL;
 
     if (pthread_mutex_init(&server->server_mutex, NULL) != 0) {
@@ -20,6 +21,280 @@ int uds_server_init(struct uds_server* server) {
     return 0;
 }
 
+static int uds_buffer_reserve(struct uds_buffer* buffer, size_t extra) {
+    if (buffer->capacity - buffer->len >= extra) {
+        return 0;
+    }
+
+    size_t capacity = buffer->capacity ? buffer->capacity : UDS_RECV_CHUNK;
+    while (capacity - buffer->len < extra) {
+        capacity *= 2;
+    }
+    char* data = realloc(buffer->data, capacity);
+    if (!data) {
+        return -1;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 0;
+}
+
+// epoll reports writability only while there is something queued, otherwise it would wake the thread constantly
+static int uds_client_watch_output(struct uds_server* server, struct uds_client* client, int on) {
+    if (client->output_armed == on) {
+        return 0;
+    }
+    client->output_armed = on;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = on ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.ptr = client;
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, client->fd, &ev);
+}
+
+// called with server_mutex held. sends as much of the outbox as the socket takes without blocking;
+// the rest goes out on EPOLLOUT, so a frame is never cut short. -1 if the peer is gone
+static int uds_client_flush(struct uds_server* server, struct uds_client* client) {
+    struct uds_buffer* outbox = &client->outbox;
+    size_t done = 0;
+    while (done < outbox->len) {
+        ssize_t sent = send(client->fd, outbox->data + done, outbox->len - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent == -1) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        done += (size_t)sent;
+    }
+    memmove(outbox->data, outbox->data + done, outbox->len - done);
+    outbox->len -= done;
+
+    return uds_client_watch_output(server, client, outbox->len > 0);
+}
+
+// called with server_mutex held. marks the client and wakes the server thread to close it
+static void uds_client_fail(struct uds_server* server, struct uds_client* client, const char* what) {
+    if (server->is_running) {
+        perror(what);
+    }
+    client->closing = 1;
+    uint64_t one = 1;
+    if (write(server->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write");
+    }
+}
+
+// called with server_mutex held. the whole frame is queued behind anything still unsent, then flushed.
+// a client that lets UDS_MAX_OUTBOX pile up has stopped reading and is dropped instead of blocking the rest
+static int uds_client_send(struct uds_server* server, struct uds_client* client,
+                           enum uds_message_type type, const char* payload, size_t len) {
+    if (client->closing) {
+        return -1;
+    }
+
+    struct uds_buffer* outbox = &client->outbox;
+    if (outbox->len + UDS_HEADER_SIZE + len > UDS_MAX_OUTBOX) {
+        errno = ENOBUFS;
+        uds_client_fail(server, client, "client not reading");
+        return -1;
+    }
+    if (uds_buffer_reserve(outbox, UDS_HEADER_SIZE + len) < 0) {
+        errno = ENOMEM;
+        uds_client_fail(server, client, "queue message for client");
+        return -1;
+    }
+
+    unsigned char* header = (unsigned char*)outbox->data + outbox->len;
+    header[0] = (unsigned char)(len >> 24);
+    header[1] = (unsigned char)(len >> 16);
+    header[2] = (unsigned char)(len >> 8);
+    header[3] = (unsigned char)len;
+    header[4] = (unsigned char)type;
+    if (len > 0) {
+        memcpy(outbox->data + outbox->len + UDS_HEADER_SIZE, payload, len);
+    }
+    outbox->len += UDS_HEADER_SIZE + len;
+
+    if (uds_client_flush(server, client) < 0) {
+        uds_client_fail(server, client, "send to client");
+        return -1;
+    }
+    return 0;
+}
+
+// called with server_mutex held
+static void uds_client_fetch(struct uds_server* server, struct uds_client* client, double now) {
+    if (uds_client_send(server, client, UDS_MSG_FETCH, NULL, 0) == 0) {
+        client->fetch_pending = 1;
+        client->fetch_time = now;
+        client->fetches_sent++;
+    }
+}
+
+// asks the fetcher that has been idle longest for more reels. fetchers still working on an
+// earlier fetch are skipped, so parallel producers each fill part of the queue. with none free
+// the request is latched and sent once one answers or times out. called with server_mutex held
+static int uds_server_dispatch_fetch(struct uds_server* server) {
+    double now = get_time_in_seconds();
+    struct uds_client* idle = NULL;
+    for (int i = 0; i < server->client_count; i++) {
+        struct uds_client* client = server->clients[i];
+        if (!client->fetcher || client->closing) continue;
+        // a producer that never answered shouldn't be skipped forever
+        if (client->fetch_pending && now - client->fetch_time < UDS_FETCH_TIMEOUT) continue;
+        if (!idle || client->fetch_time < idle->fetch_time) {
+            idle = client;
+        }
+    }
+    if (!idle) {
+        server->fetch_wanted = 1;
+        return -1;
+    }
+    server->fetch_wanted = 0;
+    uds_client_fetch(server, idle, now);
+    return 0;
+}
+
+// adds a whole batch under one lock and wakes the preloader and main loop once
+static void uds_server_handle_urls(struct uds_server* server, struct uds_client* client, const char* payload, size_t len) {
+    char* urls = malloc(len + 1);
+    if (!urls) {
+        fprintf(stderr, "Failed to allocate URL batch\n");
+        return;
+    }
+    memcpy(urls, payload, len);
+    urls[len] = '\0';
+
+    int received = 0;
+    int added = 0;
+    // the server thread is the playlist's only writer, readers never wait on it
+    char* url = urls;
+    while (url && *url) {
+        char* next = strchr(url, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+        if (*url) {
+            if (playlist_push_unique(server->app->video_list, url) > 0) {
+                playlist* list = server->app->video_list;
+                session_append(&server->app->session, url, playlist_size(list) - 1, playlist_first(list));
+                added++;
+            }
+            received++;
+        }
+        url = next;
+    }
+    free(urls);
+
+    if (added > 0) {
+        preloader_notify(&server->app->preloader);
+        event_loop_notify(&server->app->events);
+    }
+
+    char ack[32];
+    int ack_len = snprintf(ack, sizeof(ack), "%d %d", added, received);
+
+    pthread_mutex_lock(&server->server_mutex);
+    server->urls_received += received;
+    server->batches_received++;
+    client->urls_received += received;
+    client->urls_added += added;
+    client->batches_received++;
+    client->fetch_pending = 0; // answered, it can be asked again
+    uds_client_send(server, client, UDS_MSG_ACK, ack, (size_t)ack_len);
+    if (server->fetch_wanted) {
+        uds_server_dispatch_fetch(server);
+    }
+    pthread_mutex_unlock(&server->server_mutex);
+}
+
+static void uds_server_handle_message(struct uds_server* server, struct uds_client* client, enum uds_message_type type,
+                                      const char* payload, size_t len) {
+    switch (type) {
+        case UDS_MSG_URLS:
+            if (server->app && server->app->video_list) {
+                uds_server_handle_urls(server, client, payload, len);
+            }
+            break;
+        case UDS_MSG_HELLO:
+            // a new producer starts filling the queue right away, playback may already be running off a
+            // restored session. that also covers a fetch that was waiting for one
+            pthread_mutex_lock(&server->server_mutex);
+            client->fetcher = 1;
+            server->fetch_wanted = 0;
+            uds_client_fetch(server, client, get_time_in_seconds());
+            pthread_mutex_unlock(&server->server_mutex);
+            break;
+        case UDS_MSG_STATS: {
+            size_t json_len = 0;
+            char* json = stats_format_json(server->app ? &server->app->governor : NULL, &json_len);
+            if (!json) {
+                fprintf(stderr, "Failed to format stats\n");
+                break;
+            }
+            pthread_mutex_lock(&server->server_mutex);
+            uds_client_send(server, client, UDS_MSG_STATS, json, json_len);
+            pthread_mutex_unlock(&server->server_mutex);
+            free(json);
+            break;
+        }
+        default:
+            fprintf(stderr, "Ignoring unexpected UDS message type %d\n", (int)type);
+            break;
+    }
+}
+
+// splits the buffer into complete messages, keeping a trailing partial one for the next recv.
+// -1 if the peer sent something that can't be a message
+static int uds_server_process(struct uds_server* server, struct uds_client* client) {
+    struct uds_buffer* buffer = &client->buffer;
+    size_t offset = 0;
+    while (buffer->len - offset >= UDS_HEADER_SIZE) {
+        const unsigned char* header = (const unsigned char*)buffer->data + offset;
+        size_t len = ((size_t)header[0] << 24) | ((size_t)header[1] << 16) | ((size_t)header[2] << 8) | header[3];
+        if (len > UDS_MAX_MESSAGE) {
+            fprintf(stderr, "UDS message of %zu bytes is too large, dropping client\n", len);
+            return -1;
+        }
+        if (buffer->len - offset < UDS_HEADER_SIZE + len) {
+            break;
+        }
+
+        uds_server_handle_message(server, client, (enum uds_message_type)header[4],
+                                  buffer->data + offset + UDS_HEADER_SIZE, len);
+        offset += UDS_HEADER_SIZE + len;
+    }
+
+    memmove(buffer->data, buffer->data + offset, buffer->len - offset);
+    buffer->len -= offset;
+    return 0;
+}
+
+static void uds_server_close_fds(struct uds_server* server) {
+    if (server->server_fd != -1) {
+        close(server->server_fd);
+        server->server_fd = -1;
+    }
+    if (server->epoll_fd != -1) {
+        close(server->epoll_fd);
+        server->epoll_fd = -1;
+    }
+    if (server->wake_fd != -1) {
+        close(server->wake_fd);
+        server->wake_fd = -1;
+    }
+}
+
+// the listening socket is tagged with a NULL pointer, the wake eventfd with the server itself
+// and every client with its own struct
+static int uds_server_watch(struct uds_server* server, int fd, void* tag) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = tag;
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
 int uds_server_start(struct uds_server* server) {
     if (!server) {
         return -1;
@@ -49,16 +324,26 @@ int uds_server_start(struct uds_server* server) {
     
     if (bind(server->server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) == -1) {
         perror("bind");
-        close(server->server_fd);
-        server->server_fd = -1;
+        uds_server_close_fds(server);
         pthread_mutex_unlock(&server->server_mutex);
         return -1;
     }
 
-    if (listen(server->server_fd, 5) == -1) {
+    if (listen(server->server_fd, 16) == -1) {
         perror("listen");
-        close(server->server_fd);
-        server->server_fd = -1;
+        uds_server_close_fds(server);
+        unlink(SOCKET_PATH);
+        pthread_mutex_unlock(&server->server_mutex);
+        return -1;
+    }
+
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    server->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->epoll_fd == -1 || server->wake_fd == -1 ||
+        uds_server_watch(server, server->server_fd, NULL) == -1 ||
+        uds_server_watch(server, server->wake_fd, server) == -1) {
+        perror("epoll");
+        uds_server_close_fds(server);
         unlink(SOCKET_PATH);
         pthread_mutex_unlock(&server->server_mutex);
         return -1;
@@ -69,8 +354,7 @@ int uds_server_start(struct uds_server* server) {
     if (pthread_create(&server->server_thread, NULL, uds_server_thread_func, server) != 0) {
         perror("pthread_create");
         server->is_running = 0;
-        close(server->server_fd);
-        server->server_fd = -1;
+        uds_server_close_fds(server);
         unlink(SOCKET_PATH);
         pthread_mutex_unlock(&server->server_mutex);
         return -1;
@@ -94,16 +378,22 @@ void uds_server_stop(struct uds_server* server) {
 
     server->is_running = 0;
 
-    if (server->server_fd != -1) {
-        close(server->server_fd);
-        server->server_fd = -1;
+    // tell connected producers to shut down while they are still connected
+    for (int i = 0; i < server->client_count; i++) {
+        uds_client_send(server, server->clients[i], UDS_MSG_EXIT, NULL, 0);
+    }
+
+    uint64_t one = 1;
+    if (write(server->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("eventfd write");
     }
 
     pthread_mutex_unlock(&server->server_mutex);
 
-    // wait for thread to finish
+    // wait for thread to finish, it closes the clients on its way out
     pthread_join(server->server_thread, NULL);
 
+    uds_server_close_fds(server);
     unlink(SOCKET_PATH);
 }
 
@@ -113,139 +403,212 @@ void uds_server_cleanup(struct uds_server* server) {
     }
 
     uds_server_stop(server);
+    free(server->clients);
+    server->clients = NULL;
     pthread_mutex_destroy(&server->server_mutex);
 }
 
-void uds_server_send(struct uds_server* server, char* message){
-    if (!server || !message) {
-        return;
+// sent to every connected client
+int uds_server_send(struct uds_server* server, enum uds_message_type type, const char* payload, size_t len) {
+    if (!server) {
+        return -1;
     }
 
+    int sent = 0;
     pthread_mutex_lock(&server->server_mutex);
+    for (int i = 0; i < server->client_count; i++) {
+        sent += uds_client_send(server, server->clients[i], type, payload, len) == 0;
+    }
+    pthread_mutex_unlock(&server->server_mutex);
+    return sent > 0 ? 0 : -1;
+}
 
-    if (!server->is_running || !server->client_connected || server->client_fd == -1) { // no client dont send
-        pthread_mutex_unlock(&server->server_mutex);
-        return;
+// from the main thread. 0 if a fetcher was asked, -1 if none is free right now, in which case
+// the request is kept and sent as soon as one is
+int uds_server_request_fetch(struct uds_server* server) {
+    if (!server) {
+        return -1;
     }
 
-    ssize_t bytes_sent = send(server->client_fd, message, strlen(message), 0);
-    if (bytes_sent == -1) {
-        perror("send to client");
-        server->client_connected = 0;
-        server->client_fd = -1;
+    pthread_mutex_lock(&server->server_mutex);
+    int ret = uds_server_dispatch_fetch(server);
+    if (ret < 0 && server->is_running) {
+        // the server thread may be sleeping without a timeout, it has to start watching the clock
+        uint64_t one = 1;
+        if (write(server->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            perror("eventfd write");
+        }
     }
     pthread_mutex_unlock(&server->server_mutex);
+    return ret;
 }
 
+static void uds_server_accept(struct uds_server* server) {
+    int client_fd = accept(server->server_fd, NULL, NULL);
+    if (client_fd == -1) {
+        if (server->is_running && errno != EBADF && errno != EINVAL) {
+            perror("accept");
+        }
+        return;
+    }
+    fcntl(client_fd, F_SETFD, FD_CLOEXEC);
 
-void* uds_server_thread_func(void* arg) {
-    struct uds_server* server = (struct uds_server*)arg;
-    int client_fd;
-    struct sockaddr_un client_addr;
-    socklen_t client_len;
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_received, bytes_sent;
-    fd_set readfds;
-    struct timeval timeout;
-    int select_result;
-    int server_fd_copy;
-
-    while (server->is_running) {
+    struct uds_client* client = calloc(1, sizeof(struct uds_client));
+    if (!client) {
+        fprintf(stderr, "Failed to allocate UDS client\n");
+        close(client_fd);
+        return;
+    }
+    client->fd = client_fd;
 
-        // get a copy of server_fd under mutex protection
-        pthread_mutex_lock(&server->server_mutex);
-        server_fd_copy = server->server_fd;
-        pthread_mutex_unlock(&server->server_mutex);
+    // watched before other threads can see it, so a send from them can always switch on EPOLLOUT
+    if (uds_server_watch(server, client_fd, client) == -1) {
+        perror("epoll_ctl");
+        close(client_fd);
+        free(client);
+        return;
+    }
 
-        if (server_fd_copy == -1 || !server->is_running) {
-            break;
+    pthread_mutex_lock(&server->server_mutex);
+    if (server->client_count == server->client_capacity) {
+        int capacity = server->client_capacity ? server->client_capacity * 2 : 4;
+        struct uds_client** clients = realloc(server->clients, capacity * sizeof(struct uds_client*));
+        if (!clients) {
+            pthread_mutex_unlock(&server->server_mutex);
+            fprintf(stderr, "Failed to grow UDS client list\n");
+            epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
+            close(client_fd);
+            free(client);
+            return;
         }
+        server->clients = clients;
+        server->client_capacity = capacity;
+    }
+    server->clients[server->client_count++] = client;
+    pthread_mutex_unlock(&server->server_mutex);
+    // nothing is sent until it says what it is: a fetcher sends HELLO, a stats query just asks
+}
 
-        // use select with timeout to check for incoming connections
-        FD_ZERO(&readfds);
-        FD_SET(server_fd_copy, &readfds);
-
-        timeout.tv_sec = 0.5; // 0.5 seconds timeout
-        timeout.tv_usec = 0;
-
-        select_result = select(server_fd_copy + 1, &readfds, NULL, NULL, &timeout);
+static void uds_server_remove_client(struct uds_server* server, struct uds_client* client) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
 
-        if (select_result == -1) {
-            if (server->is_running && errno != EBADF) {
-                perror("select");
-            }
+    pthread_mutex_lock(&server->server_mutex);
+    for (int i = 0; i < server->client_count; i++) {
+        if (server->clients[i] == client) {
+            server->clients[i] = server->clients[--server->client_count];
             break;
-        } else if (select_result == 0) {
-            continue;
         }
+    }
+    // the reels it was asked for won't come, another fetcher gets the request
+    if (client->fetch_pending && server->is_running) {
+        uds_server_dispatch_fetch(server);
+    }
+    pthread_mutex_unlock(&server->server_mutex);
 
-        if (!FD_ISSET(server_fd_copy, &readfds)) {
-            continue;
-        }
+    close(client->fd);
+    free(client->buffer.data);
+    free(client->outbox.data);
+    free(client);
+}
 
-        client_len = sizeof(client_addr);
-        client_fd = accept(server_fd_copy, (struct sockaddr*)&client_addr, &client_len);
+// reads whatever the client sent and handles every complete message in it. -1 once it is gone
+static int uds_server_read_client(struct uds_server* server, struct uds_client* client) {
+    if (uds_buffer_reserve(&client->buffer, UDS_RECV_CHUNK) < 0) {
+        fprintf(stderr, "Failed to grow UDS receive buffer\n");
+        return -1;
+    }
 
-        if (client_fd == -1) {
-            if (server->is_running && errno != EBADF && errno != EINVAL) {
-                perror("accept");
-            }
-            continue;
+    struct uds_buffer* buffer = &client->buffer;
+    ssize_t bytes_received = recv(client->fd, buffer->data + buffer->len, buffer->capacity - buffer->len, 0);
+    if (bytes_received <= 0) {
+        if (bytes_received < 0 && errno == EINTR) {
+            return 0;
+        }
+        if (bytes_received < 0 && server->is_running) {
+            perror("recv");
         }
+        return -1;
+    }
+    buffer->len += (size_t)bytes_received;
 
-        // Store the client connection
-        pthread_mutex_lock(&server->server_mutex);
-        server->client_fd = client_fd;
-        server->client_connected = 1;
-        pthread_mutex_unlock(&server->server_mutex);
+    return uds_server_process(server, client);
+}
 
-        while (server->is_running) {
-            bytes_received = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-            if (bytes_received <= 0) {
-                if (server->is_running) {
-                    perror("recv");
-                }
+// clients whose sends failed on another thread, closed here where nothing else is using them
+static void uds_server_reap_closing(struct uds_server* server) {
+    while (1) {
+        struct uds_client* closing = NULL;
+        pthread_mutex_lock(&server->server_mutex);
+        for (int i = 0; i < server->client_count; i++) {
+            if (server->clients[i]->closing) {
+                closing = server->clients[i];
                 break;
             }
+        }
+        pthread_mutex_unlock(&server->server_mutex);
 
-            buffer[bytes_received] = '\0';
-
-            // remove trailing newlines
-            size_t len = strlen(buffer);
-            if (len > 0 && buffer[len - 1] == '\n') {
-                buffer[len - 1] = '\0';
-            }
+        if (!closing) break;
+        uds_server_remove_client(server, closing);
+    }
+}
 
-            // printf("UDS Server received from Python: %s\n", buffer);
+void* uds_server_thread_func(void* arg) {
+    struct uds_server* server = (struct uds_server*)arg;
+    struct epoll_event events[UDS_MAX_EVENTS];
 
-            // add the received message to the video list
-            if (server->app && server->app->video_list) {
-                pthread_mutex_lock(&server->app->video_list_mutex);
-                vector_push_back_unique(server->app->video_list, buffer);
-                pthread_mutex_unlock(&server->app->video_list_mutex);
-                // printf("Added video to list: %s\n", buffer);
-            }
+    while (server->is_running) {
+        // a latched fetch waits for a busy fetcher to answer or time out, so look again now and then
+        pthread_mutex_lock(&server->server_mutex);
+        int timeout = server->fetch_wanted ? UDS_FETCH_RETRY_MS : -1;
+        pthread_mutex_unlock(&server->server_mutex);
 
-            // echo the message back with a confirmation
-            char response[BUFFER_SIZE];
-            snprintf(response, sizeof(response), "Video added to list: %s", buffer);
+        int count = epoll_wait(server->epoll_fd, events, UDS_MAX_EVENTS, timeout);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
 
-            bytes_sent = send(client_fd, response, strlen(response), 0);
-            if (bytes_sent == -1) {
-                if (server->is_running) {
-                    perror("send");
+        for (int i = 0; i < count && server->is_running; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == NULL) {
+                uds_server_accept(server);
+            } else if (tag == server) {
+                uint64_t counter;
+                if (read(server->wake_fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN) {
+                    perror("eventfd read");
+                }
+            } else {
+                struct uds_client* client = (struct uds_client*)tag;
+                int gone = 0;
+                if (events[i].events & EPOLLOUT) {
+                    pthread_mutex_lock(&server->server_mutex);
+                    if (!client->closing && uds_client_flush(server, client) < 0) {
+                        uds_client_fail(server, client, "send to client");
+                    }
+                    pthread_mutex_unlock(&server->server_mutex);
+                }
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    gone = uds_server_read_client(server, client) < 0;
+                }
+                if (gone) {
+                    uds_server_remove_client(server, client);
                 }
-                break;
             }
         }
 
-        // Client disconnected, update state
+        uds_server_reap_closing(server);
+
         pthread_mutex_lock(&server->server_mutex);
-        server->client_connected = 0;
-        server->client_fd = -1;
+        if (server->fetch_wanted) {
+            uds_server_dispatch_fetch(server);
+        }
         pthread_mutex_unlock(&server->server_mutex);
+    }
 
-        close(client_fd);
+    // disconnect everyone; the list itself is freed in uds_server_cleanup
+    while (server->client_count > 0) {
+        uds_server_remove_client(server, server->clients[0]);
     }
 
     // printf("UDS Server thread exiting\n");
@@ -1,8 +1,9 @@
 #include "include/video_player.h"
 
+// drains all pending input, so a level-triggered wait on the input fd doesn't spin
 int input_check_quit(struct notcurses* nc) {
     ncinput input;
-    if (notcurses_get_nblock(nc, &input) > 0) {
+    while (notcurses_get_nblock(nc, &input) > 0) {
         if (input.id == 'q' || input.id == 'Q') {
             return 1;
         }
@@ -10,9 +11,10 @@ int input_check_quit(struct notcurses* nc) {
     return 0;
 }
 
+// handles every pending key, not just one, so the event loop only wakes once per burst of input
 int input_handle(struct app_state* app, struct notcurses* nc, struct video_player* player) {
     ncinput input;
-    if (notcurses_get_nblock(nc, &input) > 0) {
+    while (notcurses_get_nblock(nc, &input) > 0) {
         switch (input.id) {
             case 'q':
             case 'Q':
@@ -20,37 +22,47 @@ int input_handle(struct app_state* app, struct notcurses* nc, struct video_playe
                 // stop the UDS server to unblock pthread_join
                 // uds_server_stop(&app->server);
                 return 1; // quit
+            case 'd':
+            case 'D': // telemetry under the controls, picked up on the next panel update
+                app->debug_panel = !app->debug_panel;
+                break;
+            case NCKEY_RESIZE:
+                notcurses_refresh(nc, &app->rows, &app->cols);
+                app->layout_changed = true;
+                break;
             case NCKEY_SPACE: // space to toggle pause
+                player->is_paused = !player->is_paused;
                 if (player->audio) {
-                    if (player->audio->is_paused) {
-                        audio_resume(player->audio);
-                    } else {
+                    if (player->is_paused) {
                         audio_pause(player->audio);
+                    } else {
+                        audio_resume(player->audio);
                     }
                 }
                 break;
             case NCKEY_UP: // go back a video
-                if (app->video_index > 0) { // dont scroll if at 0
+                if (app->video_index > (int)playlist_first(app->video_list)) { // dont scroll past the oldest reel still kept
                     app->video_index--;
                     app->video_scroll = true;
+                    app->metrics.scroll_time = get_time_in_seconds();
                     return 1;
                 }
                 break;
-            case NCKEY_DOWN:
+            case NCKEY_DOWN: {
                 // handle scroll input if needed
-                pthread_mutex_lock(&app->video_list_mutex);
-                size_t video_list_size = app->video_list->size;
-                pthread_mutex_unlock(&app->video_list_mutex);
-                
+                size_t video_list_size = playlist_size(app->video_list);
+
                 if(app->video_index < (int)(video_list_size - 2)){
-                    uds_server_send(&app->server, "fetch");
+                    uds_server_request_fetch(&app->server);
                 }
 
                 if (app->video_index < (int)(video_list_size - 1)) {
                     app->video_index++;
                     app->video_scroll = true;
+                    app->metrics.scroll_time = get_time_in_seconds();
                 }
                 return 1;
+            }
         }
     }
     return 0;
@@ -67,30 +79,21 @@ double get_time_in_seconds(void) {
     return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
-void sync_video_to_audio(struct video_player* player) {
-    if (!player->audio || !player->audio->is_playing) {
-        return;
-    }
-    
-    double video_time = player->sync.video_clock;
-    double audio_time = player->audio->audio_clock;
-    double diff = video_time - audio_time;
-    
-    player->sync.audio_clock = audio_time;
-    
-    // if video is ahead of audio by more than frame duration, wait
-    if (diff > player->frame_duration) {
-        double sleep_time = diff - player->frame_duration;
-        if (sleep_time > 0 && sleep_time < 0.1) { // cap at 100ms
-            struct timespec ts;
-            ts.tv_sec = (time_t)sleep_time;
-            ts.tv_nsec = (long)((sleep_time - ts.tv_sec) * 1000000000);
-            nanosleep(&ts, NULL);
-        }
+const char* codec_thread_type_name(enum codec_thread_type type) {
+    switch (type) {
+    case CODEC_THREADS_FRAME: return "frame";
+    case CODEC_THREADS_SLICE: return "slice";
+    default: return "auto";
     }
-    // if video is behind by more than 2 frame durations, skip timing adjustment
-    else if (diff < -2 * player->frame_duration) {
-        // video is significantly behind, skip sleep to catch up
-        return;
+}
+
+// set before avcodec_open2. a type the codec can't do is ignored by FFmpeg, which then decodes on
+// one thread; 0 threads lets it start one per core
+void codec_set_threads(AVCodecContext* codec_ctx, int threads, enum codec_thread_type type) {
+    codec_ctx->thread_count = threads;
+    switch (type) {
+    case CODEC_THREADS_FRAME: codec_ctx->thread_type = FF_THREAD_FRAME; break;
+    case CODEC_THREADS_SLICE: codec_ctx->thread_type = FF_THREAD_SLICE; break;
+    default: codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE; break;
     }
 }
@@ -1,30 +1,366 @@
 #include "include/video_player.h"
 
-int video_load(struct video_player* player, const char* filename) {
+static int video_decoder_open(struct video_player* player, const struct app_config* config) {
+    AVStream* stream = player->demux.format_ctx->streams[player->demux.video_stream_index];
+
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        fprintf(stderr, "Failed to find video decoder\n");
+        return -1;
+    }
+
+    player->codec_ctx = avcodec_alloc_context3(codec);
+    if (!player->codec_ctx) {
+        fprintf(stderr, "Failed to allocate video codec context\n");
+        return -1;
+    }
+
+    int ret = avcodec_parameters_to_context(player->codec_ctx, stream->codecpar);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to copy video codec parameters: %s\n", av_err2str(ret));
+        return -1;
+    }
+    player->codec_ctx->pkt_timebase = stream->time_base;
+    codec_set_threads(player->codec_ctx, config->video_threads, config->video_thread_type);
+
+    ret = avcodec_open2(player->codec_ctx, codec, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to open video codec: %s\n", av_err2str(ret));
+        return -1;
+    }
+    player->decode_threads = player->codec_ctx->thread_count; // 0 resolved to the core count
+
+    player->packet = av_packet_alloc();
+    player->frame = av_frame_alloc();
+    if (!player->packet || !player->frame) {
+        fprintf(stderr, "Failed to allocate video packet or frame\n");
+        return -1;
+    }
+
+    if (frame_queue_init(&player->frames, config->frame_queue_depth) < 0) {
+        fprintf(stderr, "Failed to allocate frame queue\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void video_decoder_close(struct video_player* player) {
+    video_decoder_stop(player);
+
+    if (player->sws_ctx) {
+        sws_freeContext(player->sws_ctx);
+        player->sws_ctx = NULL;
+    }
+    if (player->codec_ctx) {
+        avcodec_free_context(&player->codec_ctx);
+    }
+    av_packet_free(&player->packet);
+    av_frame_free(&player->frame);
+    frame_queue_free(&player->frames);
+}
+
+// pulls packets from the demuxer until the codec hands back a frame in player->frame
+static int video_receive_frame(struct video_player* player) {
+    while (1) {
+        int ret = avcodec_receive_frame(player->codec_ctx, player->frame);
+        if (ret == 0) {
+            return 0;
+        }
+        if (ret == AVERROR_EOF) {
+            return 1;
+        }
+        if (ret != AVERROR(EAGAIN)) {
+            fprintf(stderr, "Error decoding video frame: %s\n", av_err2str(ret));
+            return -1;
+        }
+
+        // decoder wants more input
+        ret = packet_queue_get(&player->demux.video_queue, player->packet, 1);
+        if (ret < 0) {
+            if (player->decode_abort) {
+                return 1;
+            }
+            // demuxer is done, drain whatever the decoder still holds
+            avcodec_send_packet(player->codec_ctx, NULL);
+            continue;
+        }
+
+        ret = avcodec_send_packet(player->codec_ctx, player->packet);
+        av_packet_unref(player->packet);
+        if (ret < 0 && ret != AVERROR(EAGAIN)) {
+            fprintf(stderr, "Error sending video packet: %s\n", av_err2str(ret));
+            return -1;
+        }
+    }
+}
+
+// largest size with the frame's aspect ratio that fits the output box; the decoded size if there is no box yet
+static void video_fit_size(const AVFrame* frame, uint64_t target, int* width, int* height) {
+    int box_width = (int)(target >> 32);
+    int box_height = (int)(target & 0xffffffff);
+
+    if (box_width <= 0 || box_height <= 0) {
+        *width = frame->width;
+        *height = frame->height;
+        return;
+    }
+
+    if ((int64_t)frame->width * box_height > (int64_t)box_width * frame->height) {
+        *width = box_width;
+        *height = (int)((int64_t)frame->height * box_width / frame->width);
+    } else {
+        *height = box_height;
+        *width = (int)((int64_t)frame->width * box_height / frame->height);
+    }
+    if (*width < 1) *width = 1;
+    if (*height < 1) *height = 1;
+}
+
+// converts the decoded frame to RGBA at the size the blitter will draw it, into a ring slot.
+// scaling here keeps it off the render loop and shrinks the buffers the ring and ncvisual copy around.
+static int video_convert_frame(struct video_player* player, struct frame_slot* slot) {
+    AVFrame* frame = player->frame;
+    uint64_t target = player->output_size ? __atomic_load_n(player->output_size, __ATOMIC_ACQUIRE) : 0;
+    int width, height;
+    video_fit_size(frame, target, &width, &height);
+
+    int stride = width * 4;
+    size_t needed = (size_t)stride * height;
+
+    if (needed > slot->capacity) {
+        uint8_t* buffer = realloc(slot->rgba, needed);
+        if (!buffer) {
+            fprintf(stderr, "Failed to allocate RGBA buffer\n");
+            return -1;
+        }
+        slot->rgba = buffer;
+        slot->capacity = needed;
+    }
+
+    // returns the same context unless the source format or output geometry changed
+    player->sws_ctx = sws_getCachedContext(player->sws_ctx,
+                                           frame->width, frame->height, frame->format,
+                                           width, height, AV_PIX_FMT_RGBA,
+                                           SWS_BILINEAR, NULL, NULL, NULL);
+    if (!player->sws_ctx) {
+        fprintf(stderr, "Failed to create colorspace converter\n");
+        return -1;
+    }
+
+    uint8_t* dst[4] = { slot->rgba, NULL, NULL, NULL };
+    int dst_stride[4] = { stride, 0, 0, 0 };
+    sws_scale(player->sws_ctx, (const uint8_t* const*)frame->data, frame->linesize,
+              0, frame->height, dst, dst_stride);
+
+    slot->width = width;
+    slot->height = height;
+    slot->stride = stride;
+    slot->target = target;
+    slot->pts = frame->best_effort_timestamp == AV_NOPTS_VALUE ? 0.0 :
+                frame->best_effort_timestamp * av_q2d(player->codec_ctx->pkt_timebase);
+    return 0;
+}
+
+// producer side: decodes one frame into the ring, waiting for room. 0 on a frame, 1 at end, -1 on error
+int video_decode_frame(struct video_player* player) {
+    double decode_start = get_time_in_seconds();
+    int ret = video_receive_frame(player);
+    double decode_time = get_time_in_seconds() - decode_start;
+    player->decode_time += decode_time;
+    if (ret != 0) {
+        return ret;
+    }
+    stats_record(STATS_DECODE, decode_time);
+
+    // the render loop is behind or paused, sleep until it pops a frame
+    struct frame_slot* slot = frame_queue_wait_slot(&player->frames, &player->decode_abort);
+    if (!slot) {
+        av_frame_unref(player->frame);
+        return 1;
+    }
+
+    double convert_start = get_time_in_seconds();
+    ret = video_convert_frame(player, slot);
+    player->convert_time += get_time_in_seconds() - convert_start;
+    av_frame_unref(player->frame);
+    if (ret < 0) {
+        return -1;
+    }
+
+    player->frames_decoded++;
+    frame_queue_push(&player->frames);
+    if (player->frames_decoded == 1) {
+        player->first_frame_time = get_time_in_seconds() - player->load_start;
+        stats_record(STATS_FIRST_DECODE, player->first_frame_time);
+    }
+    return 0;
+}
+
+void* video_decode_thread_func(void* arg) {
+    struct video_player* player = (struct video_player*)arg;
+
+    while (!player->decode_abort) {
+        int ret = video_decode_frame(player);
+        if (ret < 0) {
+            player->decode_error = 1;
+            break;
+        }
+        if (ret == 1) {
+            break;
+        }
+    }
+
+    frame_queue_set_eof(&player->frames);
+    return NULL;
+}
+
+int video_decoder_start(struct video_player* player) {
+    if (player->decode_running) return 0;
+
+    player->decode_abort = 0;
+    int ret = pthread_create(&player->decode_thread, NULL, video_decode_thread_func, player);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to create decode thread: %s\n", strerror(ret));
+        return -1;
+    }
+    player->decode_running = 1;
+    return 0;
+}
+
+void video_decoder_stop(struct video_player* player) {
+    if (!player->decode_running) return;
+
+    __atomic_store_n(&player->decode_abort, 1, __ATOMIC_RELEASE);
+    // wake the decoder if it is waiting on the demuxer for a packet or on a full ring
+    packet_queue_abort(&player->demux.video_queue);
+    frame_queue_wake(&player->frames);
+
+    pthread_join(player->decode_thread, NULL);
+    player->decode_running = 0;
+}
+
+// consumer side: swaps the frame that is due at `now` in as the current ncvisual.
+// 0 on a new frame, VIDEO_FRAME_PENDING with *wait set to the time until the next one is due,
+// or below 0 if none is decoded yet and the decoder will write the event loop's eventfd,
+// 1 at end, -1 on error. Frames already overtaken by a newer decoded frame are dropped unblitted.
+int video_next_frame(struct video_player* player, double now, double* wait) {
+    struct frame_slot* slot;
+    double lateness;
+
+    while (1) {
+        slot = frame_queue_peek(&player->frames);
+        if (!slot) {
+            if (frame_queue_is_eof(&player->frames)) {
+                return player->decode_error ? -1 : 1;
+            }
+            *wait = -1.0;
+            return VIDEO_FRAME_PENDING;
+        }
+
+        // the first frame anchors stream time to the wall clock
+        if (!player->sync.has_start_pts) {
+            player->sync.start_pts = slot->pts;
+            player->sync.frame_timer = now;
+            player->sync.has_start_pts = 1;
+        }
+
+        double due = player->sync.frame_timer + (slot->pts - player->sync.start_pts);
+        lateness = now - due;
+        if (lateness < 0) {
+            *wait = -lateness;
+            return VIDEO_FRAME_PENDING;
+        }
+
+        // more than a frame behind with its successor already decoded: skip it, it would only delay that one
+        if (lateness > player->frame_duration && frame_queue_size(&player->frames) > 1) {
+            frame_queue_pop(&player->frames);
+            player->frames_dropped++;
+            continue;
+        }
+        break;
+    }
+
+    if (lateness > FRAME_LATE_TOLERANCE) {
+        player->frames_late++;
+    }
+
+    // notcurses copies the pixels, so the slot can go straight back to the decoder
+    struct ncvisual* ncv = ncvisual_from_rgba(slot->rgba, slot->height, slot->stride, slot->width);
+    player->frame_pts = slot->pts;
+    // frames decoded before a resize still need notcurses to scale them
+    player->frame_prescaled = slot->target != 0 &&
+                              slot->target == __atomic_load_n(player->output_size, __ATOMIC_ACQUIRE);
+    frame_queue_pop(&player->frames);
+
+    if (!ncv) {
+        fprintf(stderr, "Failed to create visual from frame\n");
+        return -1;
+    }
+
+    if (player->ncv) {
+        ncvisual_destroy(player->ncv);
+    }
+    player->ncv = ncv;
+    return 0;
+}
+
+// packet_memory caps the demuxed packets from the start: the full budget for the reel about
+// to play, a preload slot's share for one opened ahead
+int video_load(struct app_state* app, struct video_player* player, const char* filename, size_t packet_memory) {
 
     if (filename == NULL) {
         fprintf(stderr, "Error: filename is NULL\n");
         return -1;
     }
 
-    player->filename = filename;
+    player->filename = strdup(filename);
+    if (!player->filename) {
+        fprintf(stderr, "Failed to copy filename\n");
+        return -1;
+    }
     player->frame_count = 0;
     player->is_playing = 0;
+    player->output_size = &app->video_output_size;
 
     memset(&player->sync, 0, sizeof(struct av_sync));
-    player->fps = 30.0;
-    player->frame_duration = 1.0 / player->fps;
+    player->is_paused = 0;
 
-    player->ncv = ncvisual_from_file(filename);
-    if (!player->ncv) {
+    // a single open and probe per reel; both decoders are fed from this demuxer
+    player->load_start = get_time_in_seconds();
+    if (demuxer_open(&player->demux, filename, &app->cache, packet_memory, app->config.readahead_bytes) < 0) {
         fprintf(stderr, "Error opening video file '%s'\n", filename);
+        video_cleanup(player);
         return -1;
     }
+    player->open_time = get_time_in_seconds() - player->load_start;
+
+    if (video_decoder_open(player, &app->config) < 0) {
+        video_cleanup(player);
+        return -1;
+    }
+    frame_queue_set_notify(&player->frames, app->events.notify_fd);
+
+    // real stream rate for the drop threshold and clocks; scheduling itself follows each frame's pts
+    AVStream* video_stream = player->demux.format_ctx->streams[player->demux.video_stream_index];
+    AVRational frame_rate = av_guess_frame_rate(player->demux.format_ctx, video_stream, NULL);
+    player->fps = (frame_rate.num > 0 && frame_rate.den > 0) ? av_q2d(frame_rate) : DEFAULT_FPS;
+    player->frame_duration = 1.0 / player->fps;
+
+    if (app->headless) {
+        // nothing to hear in a benchmark; the demuxer drops audio packets once their queue is aborted
+        packet_queue_abort(&player->demux.audio_queue);
+        if (demuxer_start(&player->demux) < 0) {
+            video_cleanup(player);
+            return -1;
+        }
+        return 0;
+    }
 
     player->audio = malloc(sizeof(struct audio_player));
     if (!player->audio) {
         fprintf(stderr, "Failed to allocate memory for audio player\n");
-        ncvisual_destroy(player->ncv);
+        video_cleanup(player);
         return -1;
     }
 
@@ -32,68 +368,107 @@ int video_load(struct video_player* player, const char* filename) {
         fprintf(stderr, "Failed to initialize audio player\n");
         free(player->audio);
         player->audio = NULL;
-        ncvisual_destroy(player->ncv);
+        video_cleanup(player);
         return -1;
     }
 
-    if (audio_open_url(player->audio, filename) < 0) {
+    if (audio_open_stream(player->audio, &player->demux, &app->audio_out, &app->config) < 0) {
         fprintf(stderr, "Warning: Failed to open audio from video file, continuing without audio\n");
         audio_cleanup(player->audio);
         free(player->audio);
         player->audio = NULL;
+        packet_queue_abort(&player->demux.audio_queue);
+    }
+
+    if (demuxer_start(&player->demux) < 0) {
+        video_cleanup(player);
+        return -1;
     }
 
     return 0;
 }
 
+// decodes the first frame into the ring ahead of time so playback can show it immediately.
+// runs on the caller's thread, before the decode thread takes over as the ring's producer.
+int video_prime(struct video_player* player) {
+    if (player->decode_running || frame_queue_size(&player->frames) > 0) {
+        return 0;
+    }
+    return video_decode_frame(player);
+}
+
 int video_play(struct app_state* app, struct video_player* player) {
 
     player->is_playing = 1;
 
     clock_gettime(CLOCK_MONOTONIC, &player->sync.start_time);
-    player->sync.frame_timer = get_time_in_seconds();
     player->sync.video_clock = 0.0;
     player->sync.audio_clock = 0.0;
+    player->sync.has_start_pts = 0; // anchored when the first frame comes out of the ring
+    player->frames_displayed = 0;
+    player->frames_dropped = 0;
+    player->frames_late = 0;
 
-    if (player->audio) {
-        if (audio_play(player->audio) < 0) {
-            fprintf(stderr, "Warning: Failed to start audio playback\n");
+    // without a device (or its threads) nothing reads the audio queue, and a full one would block
+    // the demuxer and starve video: drop the audio and let the queue discard packets from here on
+    if (player->audio && audio_play(player->audio) < 0) {
+        fprintf(stderr, "Warning: Failed to start audio playback, continuing without audio\n");
+        audio_cleanup(player->audio);
+        free(player->audio);
+        player->audio = NULL;
+        packet_queue_abort(&player->demux.audio_queue);
+        packet_queue_flush(&player->demux.audio_queue);
+    }
+    sync_start(app, player); // follows the wall clock if the audio is gone
+
+    if (video_decoder_start(player) < 0) {
+        if (player->audio) {
+            audio_stop(player->audio);
         }
+        return -1;
     }
 
-    double next_frame_time = get_time_in_seconds();
-    struct ncplane* last_planes[120];
-    for (int i = 0; i < 120; i++) {
-        last_planes[i] = NULL;
+    double pause_started = 0.0;
+
+    // new reel: make sure the plane fits the current layout and drop the last reel's frame
+    if (video_output_plane_update(app) < 0) {
+        video_decoder_stop(player);
+        return -1;
     }
-    struct ncplane* rendered_plane = NULL;
     while (player->is_playing) {
         if (input_handle(app, app->nc, player)) {
             app->video_scroll = false;
             break;
         }
 
-        if (player->audio->is_paused){ // dont do anything while audio is paused
-            next_frame_time = get_time_in_seconds();
+        if (player->is_paused) { // dont do anything while paused, sleep until a key arrives
+            if (pause_started == 0.0) {
+                pause_started = get_time_in_seconds();
+            }
+            event_loop_disarm_timer(&app->events);
+            event_loop_wait(&app->events, -1);
             continue;
         }
+        if (pause_started > 0.0) {
+            // shift the schedule by the pause so frames aren't all late on resume
+            player->sync.frame_timer += get_time_in_seconds() - pause_started;
+            pause_started = 0.0;
+        }
 
-        double current_time = get_time_in_seconds();
+        double wait = 0.0;
+        int decode_result = video_next_frame(player, get_time_in_seconds(), &wait);
 
-        // skip frame if we're running behind
-        if (current_time < next_frame_time) {
-            double sleep_time = next_frame_time - current_time;
-            if (sleep_time > 0.001) { // only sleep if more than 1ms
-                struct timespec ts;
-                ts.tv_sec = (time_t)sleep_time;
-                ts.tv_nsec = (long)((sleep_time - ts.tv_sec) * 1000000000);
-                nanosleep(&ts, NULL);
+        if (decode_result == VIDEO_FRAME_PENDING) {
+            // not due yet: sleep until the deadline. not decoded yet: sleep until the decoder
+            // pushes it. a key wakes us earlier either way
+            if (wait < 0) {
+                event_loop_disarm_timer(&app->events);
+            } else {
+                event_loop_arm_timer(&app->events, wait < player->frame_duration ? wait : player->frame_duration);
             }
-        }
-        
-        int decode_result = ncvisual_decode(player->ncv);
-
-        if (decode_result == 1) {
+            event_loop_wait(&app->events, -1);
+            continue;
+        } else if (decode_result == 1) {
             break;
         } else if (decode_result < 0) {
             fprintf(stderr, "Error decoding frame: %d\n", decode_result);
@@ -101,56 +476,55 @@ int video_play(struct app_state* app, struct video_player* player) {
         }
 
         // Update video clock
-        player->sync.video_clock = player->frame_count * player->frame_duration;
+        player->sync.video_pts = player->frame_pts;
+        player->sync.video_clock = player->frame_pts - player->sync.start_pts;
 
-        rendered_plane = video_render_frame(app, player);
-        if (rendered_plane == NULL) {
+        // the governor is down to a fraction of the frame rate, this one is decoded but never shown
+        if (player->frame_count > 0 && governor_skip_frame(app)) {
+            player->frames_dropped++;
+            player->frame_count++;
+            continue;
+        }
+
+        if (video_render_frame(app, player) == NULL) {
             fprintf(stderr, "Error rendering frame %d\n", player->frame_count);
             break;
-        }else{
-            // Destroy the last rendered plane to avoid memory leaks
-            if (player->frame_count > 0 && player->frame_count % 120 == 0 && last_planes[player->frame_count % 120]) {
-                for (int i = 0; i < 120; i++) {
-                    if (last_planes[i]) {
-                        ncplane_destroy(last_planes[i]);
-                        last_planes[i] = NULL;
-                    }
-                }
-            }
-            last_planes[player->frame_count % 120] = rendered_plane;
         }
+        player->frames_displayed++;
 
-        // Calculate next frame time
-        next_frame_time += player->frame_duration;
-        
-        // Sync with audio if available
-        if (player->audio && player->audio->is_playing) {
-            sync_video_to_audio(player);
+        if (app->metrics.time_to_first_frame == 0) {
+            double now = get_time_in_seconds();
+            app->metrics.time_to_first_frame = now - app->metrics.start_time;
+            app->metrics.enter_to_first_frame = now - app->metrics.enter_time;
+            stats_record(STATS_ENTER, app->metrics.enter_to_first_frame);
+        }
+        if (player->frame_count == 0 && app->metrics.scroll_time > 0) {
+            double elapsed = get_time_in_seconds() - app->metrics.scroll_time;
+            app->metrics.last_scroll_to_first_frame = elapsed;
+            stats_record(STATS_SCROLL, elapsed);
+            app->metrics.total_scroll_to_first_frame += elapsed;
+            app->metrics.scrolls++;
+            app->metrics.scroll_time = 0;
         }
+
+        // measure drift against the audio clock and, when it is the master, steer the schedule toward it
+        sync_update(player, get_time_in_seconds());
         
         player->frame_count++;
     }
 
-    // clean up rendered planes
-    for (int i = 0; i < 120; i++) {
-        if (last_planes[i] != NULL) {
-            ncplane_destroy(last_planes[i]);
-            last_planes[i] = NULL;
-        }
-    }
     // Stop audio playback
     if (player->audio) {
         audio_stop(player->audio);
     }
+    video_decoder_stop(player);
 
     return 0;
 }
 
 void video_cleanup(struct video_player* player) {
-    if (player->ncv) {
-        ncvisual_destroy(player->ncv);
-        player->ncv = NULL;
-    }
+    // stop the demuxer first so nothing is still feeding the decoders
+    demuxer_stop(&player->demux);
 
     // Clean up audio player
     if (player->audio) {
@@ -159,5 +533,15 @@ void video_cleanup(struct video_player* player) {
         player->audio = NULL;
     }
 
+    video_decoder_close(player);
+    demuxer_close(&player->demux);
+
+    if (player->ncv) {
+        ncvisual_destroy(player->ncv);
+        player->ncv = NULL;
+    }
+
+    free(player->filename);
+    player->filename = NULL;
     player->is_playing = 0;
 }
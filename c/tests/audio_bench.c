@@ -0,0 +1,99 @@
+// what swresample costs per sample next to the copy into the PCM ring: for sources already in
+// the device format (packed S16 or S32 at its rate and channel count) the audio thread skips
+// swr_convert, so the copy is all that is left. planar float, what AAC decodes to, always
+// needs the conversion and is timed for reference
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+
+#define BENCH_RATE 48000
+#define BENCH_CHANNELS 2
+#define BENCH_FRAME_SAMPLES 1024 // an AAC frame
+#define BENCH_SECONDS 60
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// a minute of audio, fed through in decoder sized frames; returns samples per second
+static double bench_swr(enum AVSampleFormat in_fmt, enum AVSampleFormat out_fmt) {
+    AVChannelLayout layout;
+    av_channel_layout_default(&layout, BENCH_CHANNELS);
+    SwrContext* swr = NULL;
+    if (swr_alloc_set_opts2(&swr, &layout, out_fmt, BENCH_RATE, &layout, in_fmt, BENCH_RATE, 0, NULL) < 0 ||
+        swr_init(swr) < 0) {
+        fprintf(stderr, "Failed to set up the resampler\n");
+        exit(1);
+    }
+
+    uint8_t* in[BENCH_CHANNELS] = {0};
+    uint8_t* out = NULL;
+    int in_linesize;
+    int out_linesize;
+    if (av_samples_alloc(in, &in_linesize, BENCH_CHANNELS, BENCH_FRAME_SAMPLES, in_fmt, 0) < 0 ||
+        av_samples_alloc(&out, &out_linesize, BENCH_CHANNELS, BENCH_FRAME_SAMPLES, out_fmt, 0) < 0) {
+        fprintf(stderr, "Failed to allocate samples\n");
+        exit(1);
+    }
+    av_samples_set_silence(in, 0, BENCH_FRAME_SAMPLES, BENCH_CHANNELS, in_fmt);
+
+    long frames = (long)BENCH_RATE * BENCH_SECONDS / BENCH_FRAME_SAMPLES;
+    double start = bench_now();
+    for (long i = 0; i < frames; i++) {
+        if (swr_convert(swr, &out, BENCH_FRAME_SAMPLES, (const uint8_t**)in, BENCH_FRAME_SAMPLES) < 0) {
+            fprintf(stderr, "swr_convert failed\n");
+            exit(1);
+        }
+    }
+    double elapsed = bench_now() - start;
+
+    av_freep(&in[0]);
+    av_freep(&out);
+    swr_free(&swr);
+    av_channel_layout_uninit(&layout);
+    return frames * BENCH_FRAME_SAMPLES / elapsed;
+}
+
+// the ring write both paths end with
+static double bench_copy(enum AVSampleFormat fmt) {
+    size_t bytes = (size_t)BENCH_FRAME_SAMPLES * BENCH_CHANNELS * av_get_bytes_per_sample(fmt);
+    uint8_t* in = calloc(1, bytes);
+    uint8_t* ring = malloc(bytes * 64);
+    if (!in || !ring) {
+        fprintf(stderr, "Failed to allocate samples\n");
+        exit(1);
+    }
+
+    long frames = (long)BENCH_RATE * BENCH_SECONDS / BENCH_FRAME_SAMPLES;
+    double start = bench_now();
+    for (long i = 0; i < frames; i++) {
+        memcpy(ring + (i % 64) * bytes, in, bytes);
+        __asm__ __volatile__("" : : "r"(ring) : "memory"); // keep the copy
+    }
+    double elapsed = bench_now() - start;
+
+    free(in);
+    free(ring);
+    return frames * BENCH_FRAME_SAMPLES / elapsed;
+}
+
+int main(void) {
+    const enum AVSampleFormat packed[] = {AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_S32};
+    for (size_t i = 0; i < sizeof(packed) / sizeof(packed[0]); i++) {
+        double copy = bench_copy(packed[i]);
+        double swr = bench_swr(packed[i], packed[i]);
+        printf("%-4s -> %-4s  ring copy %8.1f Msamples/s   swr_convert %8.1f Msamples/s   bypass saves %5.1f ns/sample\n",
+               av_get_sample_fmt_name(packed[i]), av_get_sample_fmt_name(packed[i]), copy / 1e6, swr / 1e6,
+               (1 / swr) * 1e9);
+    }
+    double fltp = bench_swr(AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16);
+    printf("%-4s -> %-4s  swr_convert %8.1f Msamples/s (AAC reels, no bypass)\n", "fltp", "s16", fltp / 1e6);
+    return 0;
+}
@@ -0,0 +1,150 @@
+// reads a reel over http through media_io the way the mp4 demuxer does: the header, a jump to
+// a trailing moov, back to the start, then straight through while "decoding" each chunk.
+// every byte is checked against the local copy. before that, a read that stops after the moov
+// must leave nothing in the cache, and the full read must leave the whole reel there.
+// run against python/slow_http.py, see remote_io.sh
+//
+//     media_io_remote <url> <local copy> [readahead KB] [decode ms per 32 KB]
+#define _POSIX_C_SOURCE 200809L
+#include "include/video_player.h"
+#include <fcntl.h>
+
+#define REMOTE_CHUNK (32 * 1024)
+#define REMOTE_MOOV_BYTES (200 * 1024)
+
+static unsigned char* reference;
+static double read_stall;
+
+static double remote_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// reads n bytes at pos and compares them. -1 on a short read or a mismatch
+static int remote_read(AVIOContext* avio, uint8_t* buf, int n, int64_t pos) {
+    double start = remote_now();
+    int got = avio_read(avio, buf, n);
+    read_stall += remote_now() - start;
+    if (got != n) {
+        fprintf(stderr, "Short read at %lld: %d of %d\n", (long long)pos, got, n);
+        return -1;
+    }
+    if (memcmp(buf, reference + pos, n) != 0) {
+        fprintf(stderr, "Data mismatch in %d bytes at %lld\n", n, (long long)pos);
+        return -1;
+    }
+    return 0;
+}
+
+static int remote_read_range(AVIOContext* avio, int64_t from, int64_t to, double work) {
+    uint8_t buf[REMOTE_CHUNK];
+    for (int64_t pos = from; pos < to; pos += REMOTE_CHUNK) {
+        int n = to - pos < REMOTE_CHUNK ? (int)(to - pos) : REMOTE_CHUNK;
+        if (remote_read(avio, buf, n, pos) < 0) return -1;
+        if (work > 0) {
+            nanosleep(&(struct timespec){.tv_sec = 0, .tv_nsec = (long)(work * 1e9)}, NULL);
+        }
+    }
+    return 0;
+}
+
+// the cached copy must be there after a full read and match byte for byte, and absent otherwise
+static int remote_check_cache(struct media_cache* cache, uint64_t key, int64_t size, int expect) {
+    char path[PATH_MAX];
+    int cached = media_cache_lookup(cache, key, path, sizeof(path));
+    if (cached != expect) {
+        fprintf(stderr, expect ? "Full read left no cache entry\n" : "Partial read left a cache entry\n");
+        return -1;
+    }
+    if (!cached) return 0;
+
+    int fd = open(path, O_RDONLY);
+    unsigned char* copy = malloc(size);
+    int ok = fd >= 0 && copy && lseek(fd, 0, SEEK_END) == size && pread(fd, copy, size, 0) == size &&
+             memcmp(copy, reference, size) == 0;
+    if (fd >= 0) close(fd);
+    free(copy);
+    if (!ok) {
+        fprintf(stderr, "Cache entry %s does not match the reel\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <url> <local copy> [readahead KB] [decode ms per 32 KB]\n", argv[0]);
+        return 1;
+    }
+    size_t readahead = argc > 3 ? strtoul(argv[3], NULL, 10) * 1024 : 0;
+    double work = argc > 4 ? atof(argv[4]) / 1000 : 0.002;
+
+    int fd = open(argv[2], O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", argv[2], strerror(errno));
+        return 1;
+    }
+    int64_t size = lseek(fd, 0, SEEK_END);
+    reference = malloc(size);
+    if (!reference || pread(fd, reference, size, 0) != size || size < 2 * REMOTE_MOOV_BYTES) {
+        fprintf(stderr, "Failed to read %s, or it is too small\n", argv[2]);
+        return 1;
+    }
+    close(fd);
+
+    char cache_dir[] = "/tmp/reels-remote-XXXXXX";
+    if (!mkdtemp(cache_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    avformat_network_init();
+    struct media_cache cache;
+    if (media_cache_init(&cache, cache_dir, (uint64_t)size * 4) < 0) {
+        return 1;
+    }
+    uint64_t key = media_cache_key(argv[1]);
+    uint8_t header[32];
+    int64_t moov = size - REMOTE_MOOV_BYTES;
+    struct media_io io;
+
+    // scrolled past while opening: header and moov only, the part file has to go
+    if (media_io_open(&io, &cache, argv[1], NULL, readahead) < 0) {
+        return 1;
+    }
+    int failed = remote_read(io.avio, header, sizeof(header), 0) < 0;
+    failed = failed || avio_seek(io.avio, moov, SEEK_SET) != moov;
+    failed = failed || remote_read_range(io.avio, moov, size, 0) < 0;
+    media_io_close(&io);
+    failed = failed || remote_check_cache(&cache, key, size, 0) < 0;
+
+    read_stall = 0;
+    double start = remote_now();
+    if (media_io_open(&io, &cache, argv[1], NULL, readahead) < 0) {
+        return 1;
+    }
+    failed = failed || remote_read(io.avio, header, sizeof(header), 0) < 0;
+    failed = failed || avio_seek(io.avio, moov, SEEK_SET) != moov;
+    failed = failed || remote_read_range(io.avio, moov, size, 0) < 0;
+    failed = failed || avio_seek(io.avio, sizeof(header), SEEK_SET) != (int64_t)sizeof(header);
+    double opened = remote_now() - start;
+    failed = failed || remote_read_range(io.avio, sizeof(header), moov, work) < 0;
+    double total = remote_now() - start;
+
+    printf("readahead %5zu KB: header+moov %5.0f ms, total %6.0f ms, stalled in read %6.0f ms, %d network seeks\n",
+           readahead / 1024, opened * 1000, total * 1000, read_stall * 1000, io.fetch_seeks);
+
+    // every byte was read once, so closing commits the part file as the cache entry
+    media_io_close(&io);
+    failed = failed || remote_check_cache(&cache, key, size, 1) < 0;
+
+    media_cache_cleanup(&cache);
+    char command[PATH_MAX];
+    snprintf(command, sizeof(command), "rm -rf %s", cache_dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "Failed to remove %s\n", cache_dir);
+    }
+    free(reference);
+    avformat_network_deinit();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+// insert, duplicate check and trim cost of the playlist from 10^3 to 10^6 URLs
+#define _POSIX_C_SOURCE 200809L
+#include "playlist.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_URL_BYTES 700
+#define BENCH_KEEP 100
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// signed CDN URLs are long and share a long prefix, which is the hard case for hashing and memory
+static void bench_url(char* buf, size_t i) {
+    snprintf(buf, BENCH_URL_BYTES,
+             "https://scontent.cdninstagram.com/o1/v/t16/f2/m86/%zu.mp4?efg=eyJ2ZW5jb2RlX3RhZyI6Inhwdl9wcm9n"
+             "cmVzc2l2ZS5JTlNUQUdSQU0uQ0xJUFMuQzMuNzIwLmRhc2hfYmFzZWxpbmVfMV92MSIsInhwdl9hc3NldF9pZCI6MTc4"
+             "NTY2NTk1MjA5NzY4MjcsInZpX3VzZWNhc2VfaWQiOjEwMDk5fQ&_nc_ht=scontent.cdninstagram.com&vs=%zu&oe=67F0",
+             i, i * 7);
+}
+
+int main(void) {
+    static char url[BENCH_URL_BYTES];
+    const size_t sizes[] = {1000, 10000, 100000, 1000000};
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t n = sizes[k];
+        playlist list;
+        if (playlist_init(&list) < 0) {
+            fprintf(stderr, "Failed to initialize playlist\n");
+            return 1;
+        }
+
+        double start = bench_now();
+        for (size_t i = 0; i < n; i++) {
+            bench_url(url, i);
+            playlist_push_unique(&list, url);
+        }
+        double insert = bench_now() - start;
+
+        start = bench_now();
+        size_t duplicates = 0;
+        for (size_t i = 0; i < n; i++) {
+            bench_url(url, i);
+            duplicates += playlist_push_unique(&list, url) == 0;
+        }
+        double dup_check = bench_now() - start;
+
+        size_t arena = list.arena_bytes;
+        start = bench_now();
+        playlist_trim(&list, n - BENCH_KEEP);
+        bench_url(url, n); // the writer reclaims on its next push
+        playlist_push_unique(&list, url);
+        double trim = bench_now() - start;
+
+        printf("n=%-8zu insert %6.0f ns/op  dup-check %6.0f ns/op (%zu dups)  arena %7.1f MB  "
+               "trim to %d %7.2f ms -> %.1f MB\n",
+               n, insert / n * 1e9, dup_check / n * 1e9, duplicates, arena / 1e6, BENCH_KEEP, trim * 1e3,
+               list.arena_bytes / 1e6);
+        playlist_free(&list);
+    }
+    return 0;
+}
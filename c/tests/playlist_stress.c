@@ -0,0 +1,98 @@
+// one writer appends a million URLs while a reader trims behind it and checks every URL it reads.
+// build with -fsanitize=address (make tests) so a read of reclaimed memory fails loudly
+#define _POSIX_C_SOURCE 200809L
+#include "playlist.h"
+#include <pthread.h>
+#include <stdio.h>
+
+#define STRESS_URLS 1000000
+#define STRESS_KEEP 200 // history the reader leaves behind its trim point, like the player
+#define STRESS_MAX_ARENA (8 * 1024 * 1024) // all million URLs take ~60 MB, so more means reclaim stalled
+
+static playlist list;
+static int writer_done;
+
+static void stress_url(char* buf, size_t len, size_t i) {
+    snprintf(buf, len, "https://cdn.example.com/v/t16/%zu.mp4?oh=%zx", i, i * 2654435761u);
+}
+
+struct reader_result {
+    size_t reads;
+    size_t checked;
+    size_t bad;
+};
+
+static void* stress_reader(void* arg) {
+    struct reader_result* result = arg;
+    char expected[128];
+
+    while (!__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+        size_t size = playlist_size(&list);
+        if (size == 0) continue;
+        size_t index = size - 1 - result->reads % 64;
+        if (index >= size) index = size - 1;
+
+        // borrowed pointer: only valid between begin and end
+        playlist_read_begin(&list);
+        const char* url = playlist_get(&list, index);
+        if (url) {
+            stress_url(expected, sizeof(expected), index);
+            if (strcmp(url, expected) != 0) result->bad++;
+            result->checked++;
+        }
+        playlist_read_end(&list);
+
+        // owned copy of an older entry that the next trim may take away
+        char* copy = playlist_dup(&list, playlist_first(&list));
+        if (copy) {
+            free(copy);
+        }
+
+        if (size > STRESS_KEEP) {
+            playlist_trim(&list, size - STRESS_KEEP);
+        }
+        result->reads++;
+    }
+    return NULL;
+}
+
+int main(void) {
+    if (playlist_init(&list) < 0) {
+        fprintf(stderr, "Failed to initialize playlist\n");
+        return 1;
+    }
+
+    struct reader_result result = {0};
+    pthread_t reader;
+    if (pthread_create(&reader, NULL, stress_reader, &result) != 0) {
+        fprintf(stderr, "Failed to create reader thread\n");
+        return 1;
+    }
+
+    char url[128];
+    size_t added = 0;
+    for (size_t i = 0; i < STRESS_URLS; i++) {
+        stress_url(url, sizeof(url), i);
+        added += playlist_push_unique(&list, url) == 1;
+    }
+    // every URL is seen again, all must be rejected even though most were trimmed
+    size_t duplicates = 0;
+    for (size_t i = 0; i < STRESS_URLS; i += 997) {
+        stress_url(url, sizeof(url), i);
+        duplicates += playlist_push_unique(&list, url) == 0;
+    }
+    __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+    pthread_join(reader, NULL);
+
+    printf("playlist stress: %zu added, %zu reads, %zu checked, %zu bad, first %zu, arena %zu KB\n",
+           added, result.reads, result.checked, result.bad, playlist_first(&list), list.arena_bytes / 1024);
+
+    int failed = added != STRESS_URLS || duplicates != (STRESS_URLS + 996) / 997 || result.bad != 0 ||
+                 result.checked == 0 || list.arena_bytes > STRESS_MAX_ARENA;
+    playlist_free(&list);
+    if (failed) {
+        fprintf(stderr, "playlist stress: FAILED\n");
+        return 1;
+    }
+    return 0;
+}
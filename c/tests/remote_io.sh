@@ -0,0 +1,24 @@
+#!/bin/sh
+# serves a generated reel through python/slow_http.py like a slow CDN and reads it back
+# through media_io with read-ahead off and on, checking that only a complete read fills the cache.
+# run from c/ with the built media_io_remote
+#
+#     sh tests/remote_io.sh ../build/tests/media_io_remote [latency ms] [MB/s]
+set -e
+
+BIN=${1:-../build/tests/media_io_remote}
+LATENCY=${2:-40}
+RATE=${3:-4}
+PORT=${PORT:-8093}
+DIR=$(mktemp -d)
+
+head -c 8000000 /dev/urandom > "$DIR/reel.mp4"
+python3 ../python/slow_http.py "$DIR" --port "$PORT" --latency "$LATENCY" --rate "$RATE" 2> "$DIR/server.log" &
+SERVER=$!
+trap 'kill $SERVER 2> /dev/null; rm -rf "$DIR"' EXIT
+sleep 1
+
+for KB in 0 256 1024; do
+    "$BIN" "http://127.0.0.1:$PORT/reel.mp4" "$DIR/reel.mp4" "$KB" 2
+done
+echo "server: $(tail -n 1 "$DIR/server.log")"
@@ -0,0 +1,163 @@
+// restores a session the way a restart does and times it: resume after the last watched reel,
+// resume at the first cached reel, expired URLs, a full file after compaction, and a damaged entry
+#define _POSIX_C_SOURCE 200809L
+#include "session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define BENCH_HISTORY 100 // reels kept behind the resume point, as the player does
+#define BENCH_URL_BYTES 512
+#define BENCH_TTL (6 * 60 * 60)
+
+static char bench_dir[] = "/tmp/reels-session-XXXXXX";
+static int failures;
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_url(char* buf, size_t i) {
+    snprintf(buf, BENCH_URL_BYTES, "https://scontent.cdninstagram.com/o1/v/t16/f2/m86/AQN%0300d/%zu.mp4?oh=%zx",
+             0, i, i * 2654435761u);
+}
+
+static size_t bench_url_id(const char* url) {
+    return strtoul(strrchr(url, '/') + 1, NULL, 10);
+}
+
+// pretends the reel was downloaded before, so the restore should prefer it
+static void bench_cache_reel(struct media_cache* cache, size_t i) {
+    char url[BENCH_URL_BYTES];
+    char part[PATH_MAX];
+    bench_url(url, i);
+    uint64_t key = media_cache_key(url);
+    if (media_cache_part_path(cache, key, part, sizeof(part)) < 0) return;
+    int fd = open(part, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    close(fd);
+    media_cache_commit(cache, key, part, 1);
+}
+
+static void bench_check(const char* what, int ok) {
+    if (!ok) {
+        fprintf(stderr, "session bench: %s FAILED\n", what);
+        failures++;
+    }
+}
+
+// opens and restores into a fresh playlist, prints where playback would resume
+static int bench_restore(const char* what, struct session* session, playlist* list, struct media_cache* cache,
+                         size_t expect_id) {
+    playlist_init(list);
+    double start = bench_now();
+    session_open(session, bench_dir);
+    int index = session_restore(session, list, cache, BENCH_HISTORY, BENCH_TTL);
+    double elapsed = bench_now() - start;
+
+    char* url = playlist_dup(list, (size_t)index);
+    size_t id = url ? bench_url_id(url) : 0;
+    printf("%-22s open+restore %7.1f us, %4d reels, resume at %d (reel %zu)\n", what, elapsed * 1e6,
+           session->restored, index, id);
+    bench_check(what, url && id == expect_id);
+    free(url);
+    return index;
+}
+
+int main(void) {
+    if (!mkdtemp(bench_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char cache_dir[PATH_MAX];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/cache", bench_dir);
+
+    struct media_cache cache;
+    if (media_cache_init(&cache, cache_dir, 1 << 20) < 0) return 1;
+
+    struct session session;
+    playlist* list = malloc(sizeof(playlist)); // too big for the stack
+    char url[BENCH_URL_BYTES];
+
+    // first run: 300 reels arrive, the user watches up to 120
+    session_open(&session, bench_dir);
+    playlist_init(list);
+    for (size_t i = 0; i < 300; i++) {
+        bench_url(url, i);
+        playlist_push_unique(list, url);
+        session_append(&session, url, playlist_size(list) - 1, playlist_first(list));
+    }
+    for (size_t i = 0; i <= 120; i++) {
+        session_set_position(&session, i);
+    }
+    session_close(&session);
+    playlist_free(list);
+
+    // nothing cached: right after the last reel that was started
+    bench_restore("uncached", &session, list, &cache, 121);
+    session_close(&session);
+    playlist_free(list);
+
+    // reels further on were downloaded last time: resume jumps ahead to the first of them
+    for (size_t i = 200; i < 300; i++) {
+        bench_cache_reel(&cache, i);
+    }
+    bench_restore("cached from 200", &session, list, &cache, 200);
+    session_close(&session);
+    playlist_free(list);
+
+    // a day later the signed URLs are dead: only the cached reels come back
+    session_open(&session, bench_dir);
+    for (uint32_t i = 0; i < session.map->entry_count; i++) {
+        session.map->entries[i].saved -= 24 * 60 * 60;
+    }
+    session_close(&session);
+    bench_restore("expired", &session, list, &cache, 200);
+    bench_check("expired drops uncached", session.restored == 100);
+    session_close(&session);
+    playlist_free(list);
+
+    // worst case: appends keep compacting a full file, then a restart reads all of it
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", bench_dir, SESSION_FILE_NAME);
+    unlink(path);
+    session_open(&session, bench_dir);
+    playlist_init(list);
+    size_t appends = 20000;
+    double start = bench_now();
+    for (size_t i = 0; i < appends; i++) {
+        bench_url(url, 100000 + i);
+        playlist_push_unique(list, url);
+        session_append(&session, url, i, i > 200 ? i - 200 : 0);
+    }
+    double elapsed = bench_now() - start;
+    printf("%-22s %7.2f us per append, %u entries, %llu KB text\n", "append with compaction",
+           elapsed / appends * 1e6, session.map->entry_count, (unsigned long long)session.map->text_used / 1024);
+    size_t watched = appends - 100;
+    session_set_position(&session, watched - 1);
+    session_close(&session);
+    playlist_free(list);
+
+    bench_restore("full file", &session, list, &cache, 100000 + watched);
+
+    // a damaged entry is skipped, the rest still comes back
+    session.map->entries[5].offset = SESSION_TEXT_BYTES;
+    session_close(&session);
+    playlist_free(list);
+    bench_restore("damaged entry", &session, list, &cache, 100000 + watched);
+    session_close(&session);
+    playlist_free(list);
+    free(list);
+
+    media_cache_cleanup(&cache);
+    char command[PATH_MAX + 16];
+    snprintf(command, sizeof(command), "rm -rf %s", bench_dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "Failed to remove %s\n", bench_dir);
+    }
+    return failures ? 1 : 0;
+}
@@ -1,7 +1,6 @@
 from api import InstagramClient
-from uds_client import UDSClient
+from uds_client import UDSClient, MSG_FETCH, MSG_ACK, MSG_EXIT, MSG_HELLO
 from logger_config import logger
-import time
 
 SOCKET_PATH = "/tmp/uds_socket"
 
@@ -14,20 +13,20 @@ if __name__ == "__main__":
     insta_client = InstagramClient(USERNAME, PASSWORD)
     insta_client.login()
     uds_client = UDSClient(SOCKET_PATH)
+    uds_client.send_message(MSG_HELLO)  # only fetchers are asked for reels
     while True:
         try:
-            response = uds_client.receive_response()
-            if response is not None:
-                match response:
-                    case "exit":
-                        break
-                    case "fetch":
-                        reels = insta_client.fetch_reels(5)
-                        str_reels = [str(reel) for reel in reels]
-                        for reel in str_reels:
-                            uds_client.send_message(reel)
-                            time.sleep(0.1)
+            message = uds_client.receive_message()
+            if message is None:
+                break
+            msg_type, payload = message
+            if msg_type == MSG_EXIT:
+                break
+            elif msg_type == MSG_FETCH:
+                reels = insta_client.fetch_reels(5)
+                uds_client.send_urls([str(reel) for reel in reels])
+            elif msg_type == MSG_ACK:
+                logger.debug(f"Server added {payload.decode('utf-8')} reels")
 
         except Exception as e:
             logger.error(f"An error occurred: {e}")
-
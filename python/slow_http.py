@@ -0,0 +1,120 @@
+"""
+Serves sample reels over HTTP with artificial latency, for measuring how fast the player opens remote reels.
+
+    python slow_http.py ~/reels --latency 80 --rate 20
+    ../c/build/video_player --bench http://127.0.0.1:8080/reel1.mp4 http://127.0.0.1:8080/reel2.mp4
+
+Every request waits --latency ms before its first byte, like a far away CDN. Range requests
+and keep-alive work the way the player's http protocol expects. Each request is logged with
+the bytes it sent, so a slow open shows up as extra requests or bytes.
+"""
+import argparse
+import functools
+import os
+import sys
+import threading
+import time
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+CHUNK = 64 * 1024
+
+class Totals:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.bytes = 0
+
+class SlowHandler(SimpleHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # keep-alive, so a seek to the moov can reuse the connection
+
+    def __init__(self, *args, latency: float, rate: float, totals: Totals, **kwargs):
+        self.latency = latency
+        self.rate = rate
+        self.totals = totals
+        super().__init__(*args, **kwargs)
+
+    def log_message(self, format, *args):
+        pass  # send_file logs its own line
+
+    def do_GET(self):
+        time.sleep(self.latency)
+        path = self.translate_path(self.path)
+        if not os.path.isfile(path):
+            self.send_error(404)
+            return
+
+        size = os.path.getsize(path)
+        start, end = 0, size - 1
+        ranged = False
+        header = self.headers.get("Range")
+        if header and header.startswith("bytes="):
+            first, _, last = header[6:].split(",")[0].partition("-")
+            if first:
+                start = int(first)
+                end = int(last) if last else size - 1
+            elif last:
+                start = max(0, size - int(last))
+            end = min(end, size - 1)
+            if start >= size:
+                self.send_response(416)
+                self.send_header("Content-Range", f"bytes */{size}")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            ranged = True
+
+        self.send_response(206 if ranged else 200)
+        self.send_header("Content-Type", "video/mp4")
+        self.send_header("Accept-Ranges", "bytes")
+        self.send_header("Content-Length", str(end - start + 1))
+        if ranged:
+            self.send_header("Content-Range", f"bytes {start}-{end}/{size}")
+        self.end_headers()
+        self.send_file(path, start, end)
+
+    def send_file(self, path: str, start: int, end: int):
+        sent = 0
+        began = time.perf_counter()
+        with open(path, "rb") as f:
+            f.seek(start)
+            remaining = end - start + 1
+            try:
+                while remaining > 0:
+                    data = f.read(min(CHUNK, remaining))
+                    if not data:
+                        break
+                    self.wfile.write(data)
+                    sent += len(data)
+                    remaining -= len(data)
+                    if self.rate > 0:
+                        # hold the average at --rate MB/s
+                        ahead = sent / self.rate - (time.perf_counter() - began)
+                        if ahead > 0:
+                            time.sleep(ahead)
+            except (BrokenPipeError, ConnectionResetError):
+                pass  # the player closes a connection once it has what it needs
+
+        with self.totals.lock:
+            self.totals.requests += 1
+            self.totals.bytes += sent
+            requests, total = self.totals.requests, self.totals.bytes
+        print(f"{self.path} bytes={start}-{end} sent {sent} ({requests} requests, {total} bytes total)",
+              file=sys.stderr, flush=True)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Serve reels with artificial latency")
+    parser.add_argument("directory", help="directory with the sample reels")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--latency", type=float, default=80, help="ms before each response")
+    parser.add_argument("--rate", type=float, default=0, help="MB/s per connection, 0 for unlimited")
+    args = parser.parse_args()
+
+    handler = functools.partial(SlowHandler, directory=args.directory, latency=args.latency / 1000,
+                                rate=args.rate * 1e6, totals=Totals())
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), handler)
+    print(f"serving {args.directory} on http://127.0.0.1:{args.port} with {args.latency:.0f} ms latency",
+          file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,49 @@
+"""
+Prints the player's per-stage latency histograms and the render quality governor's decisions.
+
+While the player is running:
+    python stats.py            # percentiles per stage
+    python stats.py --json     # the raw reply, buckets included
+
+The player only asks clients that sent MSG_HELLO for reels, so this one is never asked.
+"""
+import argparse
+import json
+from uds_client import UDSClient, MSG_STATS
+
+SOCKET_PATH = "/tmp/uds_socket"
+
+def fetch_stats() -> dict:
+    client = UDSClient(SOCKET_PATH)
+    client.send_message(MSG_STATS)
+    while True:
+        message = client.receive_message()
+        if message is None:
+            raise SystemExit("server closed the connection")
+        msg_type, payload = message
+        if msg_type == MSG_STATS:
+            return json.loads(payload)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Query the player's latency histograms")
+    parser.add_argument("--json", action="store_true", help="print the raw JSON reply")
+    args = parser.parse_args()
+
+    stats = fetch_stats()
+    if args.json:
+        print(json.dumps(stats, indent=2))
+    else:
+        print(f"uptime {stats['uptime_s']:.0f}s")
+        print(f"{'stage':<22}{'count':>10}{'mean':>10}{'p50':>10}{'p90':>10}{'p99':>10}{'max':>10}  (us)")
+        for name, metric in stats["metrics"].items():
+            print(f"{name:<22}{metric['count']:>10}{metric['mean_us']:>10.1f}{metric['p50_us']:>10.1f}"
+                  f"{metric['p90_us']:>10.1f}{metric['p99_us']:>10.1f}{metric['max_us']:>10.1f}")
+
+        governor = stats.get("governor")
+        if governor and governor["enabled"]:
+            print(f"\nquality {governor['quality']} (level {governor['level']} of {governor['levels'] - 1}), "
+                  f"{governor['frame_ms']:.1f} ms/frame, {governor['bytes_per_frame']:.0f} B/frame, "
+                  f"{governor['write_mb_s']:.1f} MB/s to the terminal")
+            for decision in governor["decisions"]:
+                print(f"  {decision['t']:>8.1f}s  {decision['from']} -> {decision['to']}  "
+                      f"({decision['frame_ms']:.1f} ms/frame, budget {decision['budget_ms']:.1f})")
@@ -0,0 +1,67 @@
+"""
+Stand-in producers for measuring the UDS control socket without Instagram.
+
+Start the player and leave it on the home page, then run:
+    python uds_bench.py --producers 4 --batches 1000 --batch-size 50
+
+Each producer is its own process with its own connection, like several feeds or accounts
+running at once. Every URL is unique, so this also measures how fast the playlist grows.
+"""
+import argparse
+import multiprocessing
+import time
+from uds_client import UDSClient, MSG_ACK
+
+SOCKET_PATH = "/tmp/uds_socket"
+
+def produce(producer: int, batches: int, batch_size: int, url_length: int, results):
+    client = UDSClient(SOCKET_PATH)
+    padding = "x" * max(0, url_length - 60)
+
+    added = 0
+    start = time.perf_counter()
+    for batch in range(batches):
+        urls = [f"https://bench.invalid/reel/{producer}/{batch}/{i}.mp4?sig={padding}" for i in range(batch_size)]
+        client.send_urls(urls)
+
+        # one ack per batch, wait for it so the timing covers the player's side too
+        while True:
+            message = client.receive_message()
+            if message is None:
+                raise SystemExit("server closed the connection")
+            msg_type, payload = message
+            if msg_type == MSG_ACK:
+                added += int(payload.split()[0])
+                break
+    results.put((producer, time.perf_counter() - start, added))
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Push fake reel URLs at the player and time the acks")
+    parser.add_argument("--producers", type=int, default=1)
+    parser.add_argument("--batches", type=int, default=1000, help="per producer")
+    parser.add_argument("--batch-size", type=int, default=50)
+    parser.add_argument("--url-length", type=int, default=600, help="signed CDN URLs are often this long")
+    args = parser.parse_args()
+
+    results = multiprocessing.Queue()
+    workers = [multiprocessing.Process(target=produce,
+                                       args=(p, args.batches, args.batch_size, args.url_length, results))
+               for p in range(args.producers)]
+
+    start = time.perf_counter()
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    elapsed = time.perf_counter() - start
+
+    per_producer = args.batches * args.batch_size
+    added = 0
+    while not results.empty():
+        producer, producer_elapsed, producer_added = results.get()
+        added += producer_added
+        print(f"producer {producer}: {per_producer / producer_elapsed:.0f} URLs/s, {producer_added} added")
+
+    total = per_producer * args.producers
+    print(f"{total} URLs from {args.producers} producers: {elapsed:.3f} s, "
+          f"{total / elapsed:.0f} URLs/s, {added} added")
@@ -1,6 +1,17 @@
 import socket
+import struct
 from logger_config import logger
 
+# must match enum uds_message_type in c/include/uds_server.h
+MSG_FETCH = 1
+MSG_URLS = 2
+MSG_ACK = 3
+MSG_EXIT = 4
+MSG_STATS = 5
+MSG_HELLO = 6  # this client fetches reels, send it MSG_FETCH
+
+HEADER = struct.Struct(">IB")  # payload length, message type
+
 class UDSClient:
     def __init__(self, socket_path: str = "/tmp/uds_socket"):
         self.socket_path = socket_path
@@ -18,21 +29,42 @@ class UDSClient:
         self.client_socket.close()
         logger.info("Client socket closed")
 
-    def send_message(self, message: str):
+    def send_message(self, msg_type: int, payload: bytes = b""):
         """
-        Sends a message to the server.
-        :param message: The message to send.
+        Sends one framed message to the server.
+        :param msg_type: One of the MSG_* types.
+        :param payload: The message body.
         """
-        self.client_socket.send(message.encode('utf-8'))
-        logger.debug(f"Sent: {message}")
-    
-    def receive_response(self):
+        self.client_socket.sendall(HEADER.pack(len(payload), msg_type) + payload)
+        logger.debug(f"Sent type {msg_type}, {len(payload)} bytes")
+
+    def send_urls(self, urls: list[str]):
         """
-        Receives a response from the server.
-        :return: The response message.
+        Sends a batch of reel URLs in a single message; the server acknowledges it once.
+        :param urls: The URLs to add to the playlist.
         """
-        response = self.client_socket.recv(1024)
-        if not response:
+        self.send_message(MSG_URLS, "\n".join(urls).encode('utf-8'))
+
+    def _recv_exact(self, size: int):
+        data = bytearray()
+        while len(data) < size:
+            chunk = self.client_socket.recv(size - len(data))
+            if not chunk:
+                return None
+            data.extend(chunk)
+        return bytes(data)
+
+    def receive_message(self):
+        """
+        Receives one framed message from the server.
+        :return: A (type, payload) tuple, or None if the server closed the connection.
+        """
+        header = self._recv_exact(HEADER.size)
+        if header is None:
+            return None
+        length, msg_type = HEADER.unpack(header)
+        payload = self._recv_exact(length) if length else b""
+        if payload is None:
             return None
-        logger.debug(f"Received: {response.decode('utf-8')}")
-        return response.decode('utf-8')
\ No newline at end of file
+        logger.debug(f"Received type {msg_type}, {length} bytes")
+        return msg_type, payload